@@ -0,0 +1,148 @@
+#include "AnimatedIcon.h"
+#include <cstring>
+
+
+bool AnimatedIcon::setFrames( const byte *frames, size_t size, const uint16_t *durations, size_t durationCount )
+{
+  clear();
+  if ((size % 8 != 0) || (size / 8 > MAX_FRAMES)) {
+    return false;
+  }
+
+  m_frameCount = size / 8;
+  if (m_frameCount == 0) {
+    return true;
+  }
+
+  memcpy(m_keyframe, frames, 8);
+  for (uint8_t f = 1; f < m_frameCount; f++) {
+    if (!encodeDelta(frames + 8 * (f - 1), frames + 8 * f)) {
+      clear();
+      return false;
+    }
+  }
+
+  // A single value is enough if all frames are equally long
+  for (uint8_t f = 0; f < m_frameCount && f < durationCount; f++) {
+    m_durations[m_durationCount++] = durations[f] > 0 ? durations[f] : DEFAULT_DURATION;
+  }
+  bool uniform = true;
+  for (uint8_t i = 1; i < m_durationCount; i++) {
+    uniform = uniform && (m_durations[i] == m_durations[0]);
+  }
+  if (uniform && (m_durationCount > 1)) {
+    m_durationCount = 1;
+  }
+
+  rewind();
+  return true;
+}
+
+
+void AnimatedIcon::clear()
+{
+  m_deltaSize = 0;
+  m_durationCount = 0;
+  m_frameCount = 0;
+  memset(m_keyframe, 0, 8);
+  m_hasShade = false;
+  rewind();
+}
+
+
+bool AnimatedIcon::setShade( const byte *shade, size_t size )
+{
+  if ((size != 8) || (m_frameCount != 1)) {
+    m_hasShade = false;
+    return false;
+  }
+
+  memcpy(m_shade, shade, 8);
+  m_hasShade = true;
+  return true;
+}
+
+
+bool AnimatedIcon::appendDelta( uint8_t value )
+{
+  if (m_deltaSize == MAX_DELTA_BYTES) {
+    return false;
+  }
+  m_deltas[m_deltaSize++] = value;
+  return true;
+}
+
+
+bool AnimatedIcon::encodeDelta( const uint8_t *from, const uint8_t *to )
+{
+  uint8_t y = 0;
+  while (y < 8) {
+    uint8_t run = 0;
+    if ((from[y] ^ to[y]) == 0) {
+      while ((y + run < 8) && ((from[y + run] ^ to[y + run]) == 0)) {
+        run++;
+      }
+      if (!appendDelta(0x80 | run)) {
+        return false;
+      }
+    } else {
+      while ((y + run < 8) && ((from[y + run] ^ to[y + run]) != 0)) {
+        run++;
+      }
+      if (!appendDelta(run)) {
+        return false;
+      }
+      for (uint8_t i = 0; i < run; i++) {
+        if (!appendDelta(from[y + i] ^ to[y + i])) {
+          return false;
+        }
+      }
+    }
+    y += run;
+  }
+  return true;
+}
+
+
+uint16_t AnimatedIcon::duration() const
+{
+  if (m_durationCount == 0) {
+    return DEFAULT_DURATION;
+  }
+  return m_index < m_durationCount ? m_durations[m_index] : m_durations[m_durationCount - 1];
+}
+
+
+void AnimatedIcon::rewind()
+{
+  memcpy(m_current, m_keyframe, 8);
+  m_index = 0;
+  m_deltaPos = 0;
+}
+
+
+void AnimatedIcon::next()
+{
+  if (!animated()) {
+    return;
+  }
+
+  if (m_index + 1 == m_frameCount) {
+    rewind();
+    return;
+  }
+
+  // Apply the delta of the next frame to the current one
+  uint8_t y = 0;
+  while (y < 8) {
+    uint8_t code = m_deltas[m_deltaPos++];
+    if (code & 0x80) {
+      y += code & 0x7F;
+    } else {
+      for (uint8_t i = 0; i < code; i++) {
+        m_current[y++] ^= m_deltas[m_deltaPos++];
+      }
+    }
+  }
+  m_index++;
+}
@@ -0,0 +1,86 @@
+#ifndef ESP_INFORMER_ANIMATED_ICON_H
+#define ESP_INFORMER_ANIMATED_ICON_H
+
+#include <Arduino.h>
+
+/*
+ * An 8x8 icon with one or more frames.
+ *
+ * The first frame is kept as a keyframe, every next frame as the XOR with the
+ * previous one, run-length encoded: a byte 0x80|n skips n unchanged rows,
+ * a byte n < 0x80 is followed by n rows to XOR. A frame which changes a few rows
+ * takes a few bytes. Playback decodes the frames in order and wraps to the keyframe.
+ *
+ * All data is kept inside the object, so an icon is never allocated on the heap.
+ * Every notification, screen and the icon zone has a copy, so the capacities are
+ * kept small: the object is 128 bytes.
+ */
+class AnimatedIcon
+{
+public:
+  static constexpr uint8_t MAX_FRAMES = 16;
+  static constexpr uint16_t DEFAULT_DURATION = 200;
+
+  /* Encoded deltas of all frames. A frame takes up to 12 bytes, usually 2 - 5 */
+  static constexpr uint8_t MAX_DELTA_BYTES = 64;
+
+  /*
+   * Encodes size bytes of frames, 8 bytes each (one byte per row, MSB is the leftmost pixel).
+   * durations are milliseconds per frame, the last one is used for the rest of the frames.
+   * Returns false if the frames are not a multiple of 8 bytes, there are too many of them
+   * or their deltas do not fit MAX_DELTA_BYTES.
+   */
+  bool setFrames( const byte *frames, size_t size, const uint16_t *durations, size_t durationCount );
+
+  void clear();
+
+  /*
+   * Sets the dim bitplane of a 2-bit greyscale icon, size must be 8 bytes. The frame is the bright plane:
+   * a pixel in both planes is full brightness, only in the frame 2/3, only in the shade 1/3.
+   * Returns false for an animated icon or a wrong size, the icon stays 1-bit.
+   */
+  bool setShade( const byte *shade, size_t size );
+
+  /* The dim bitplane, nullptr for a 1-bit icon */
+  const uint8_t* shade() const { return m_hasShade ? m_shade : nullptr; }
+
+  bool empty() const { return m_frameCount == 0; }
+  bool animated() const { return m_frameCount > 1; }
+  uint8_t frameCount() const { return m_frameCount; }
+
+  /* Rows of the current frame */
+  const uint8_t* frame() const { return m_current; }
+
+  /* Milliseconds of the current frame */
+  uint16_t duration() const;
+
+  /* Goes to the first frame */
+  void rewind();
+
+  /* Decodes the next frame */
+  void next();
+
+private:
+  /* Appends the run-length encoded XOR of two frames. Returns false if it does not fit */
+  bool encodeDelta( const uint8_t *from, const uint8_t *to );
+
+  /* Appends a byte of a delta */
+  bool appendDelta( uint8_t value );
+
+  uint8_t m_keyframe[8] = {};
+  uint8_t m_deltas[MAX_DELTA_BYTES] = {};
+  uint8_t m_deltaSize = 0;
+  uint16_t m_durations[MAX_FRAMES] = {};
+  uint8_t m_durationCount = 0;          // one value if all frames have the same duration
+  uint8_t m_frameCount = 0;
+
+  uint8_t m_shade[8] = {};
+  bool m_hasShade = false;
+
+  /* Playback */
+  uint8_t m_current[8] = {};
+  uint8_t m_index = 0;
+  uint8_t m_deltaPos = 0;
+};
+
+#endif //ESP_INFORMER_ANIMATED_ICON_H
@@ -0,0 +1,48 @@
+#include "Compositor.h"
+#include "LEDMatrixDriver.h"
+
+
+void Compositor::clear( LEDMatrixDriver *driver )
+{
+  m_zones.clear();
+  driver->clear();
+}
+
+
+void Compositor::addZone( Zone *zone )
+{
+  zone->invalidate();
+  m_zones.push_back(zone);
+}
+
+
+void Compositor::invalidate()
+{
+  for (Zone *zone : m_zones) {
+    zone->invalidate();
+  }
+}
+
+
+void Compositor::restart( unsigned long now )
+{
+  for (Zone *zone : m_zones) {
+    zone->restart(now);
+  }
+}
+
+
+unsigned long Compositor::render( LEDMatrixDriver *driver, unsigned long now )
+{
+  unsigned long delay = IDLE_DELAY;
+  for (Zone *zone : m_zones) {
+    if (zone->due(now)) {
+      zone->render(driver, now);
+    }
+    unsigned long remaining = zone->remaining(now);
+    if (remaining < delay) {
+      delay = remaining;
+    }
+  }
+  return delay;
+}
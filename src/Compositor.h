@@ -0,0 +1,39 @@
+#ifndef ESP_INFORMER_COMPOSITOR_H
+#define ESP_INFORMER_COMPOSITOR_H
+
+#include <vector>
+#include "Zone.h"
+
+class LEDMatrixDriver;
+
+/*
+ * Draws a layout of zones which do not overlap.
+ * Only zones which are due are rasterised, e.g. a static icon costs nothing
+ * while the text next to it scrolls.
+ */
+class Compositor
+{
+public:
+  /* The longest delay render() returns, so timers and the button are served */
+  static const unsigned long IDLE_DELAY = 300;
+
+  /* Removes all zones and clears the display */
+  void clear( LEDMatrixDriver *driver );
+
+  /* Adds a zone to the layout, the zone is drawn completely on the next render() */
+  void addZone( Zone *zone );
+
+  /* Rasterises the zones which are due. Returns milliseconds until the next zone is due */
+  unsigned long render( LEDMatrixDriver *driver, unsigned long now );
+
+  /* Draws all zones again */
+  void invalidate();
+
+  /* Draws all zones again, animated zones start from the beginning */
+  void restart( unsigned long now );
+
+private:
+  std::vector<Zone*> m_zones;
+};
+
+#endif //ESP_INFORMER_COMPOSITOR_H
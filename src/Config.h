@@ -31,7 +31,42 @@
 #define  LEDMATRIX_SEGMENTS 8
 #define  LEDMATRIX_WIDTH  LEDMATRIX_SEGMENTS * 8
 
+/* Orientation of the matrixes */
+#define  LEDMATRIX_FLAGS (LEDMatrixDriver::INVERT_DISPLAY_X | LEDMatrixDriver::INVERT_SEGMENT_X | LEDMatrixDriver::INVERT_Y | LEDMatrixDriver::WIRE_ORDER)
+
+/* Interval (ms) to push rendered frames to the matrixes from a timer. 0 - push them from loop() */
+#define  LEDMATRIX_REFRESH_INTERVAL 20
+
+/* Milliseconds per sub-frame of greyscale icons (3 sub-frames per cycle). 0 - greyscale icons are 1-bit */
+#define  LEDMATRIX_DITHER_PERIOD 3
+
+/* Uncomment to generate the rows from a display list while they are sent, without a framebuffer (LEDMatrixStream).
+   It is for long chains: transitions, raw and streamed frames and greyscale need the framebuffer and are
+   not available, icons show their first frame */
+//#define LEDMATRIX_STREAMING
+
+/* Maximum number of screens, about 260 bytes of RAM each */
+#define  SCREEN_CAPACITY 48
+
+/* Maximum number of notifications waiting in the queue */
+#define  NOTIFICATION_CAPACITY 8
+
+/* Maximum length of the key of a notification, including the terminating zero */
+#define  NOTIFICATION_KEY_CAPACITY 16
+
+/* Maximum number of characters of a notification or a screen, a longer text is cut */
+#define  MESSAGE_TEXT_CAPACITY 64
+
+/* UDP port of the frame stream (DDP), 0 - no streaming */
+#define  STREAM_UDP_PORT 4048
+
+/* Milliseconds without a frame after which the stream is considered stopped */
+#define  STREAM_TIMEOUT 1000
+
 /* RTC pins */
+/* Interval (ms) to sync the software clock with the RTC */
+#define RTC_SYNC_INTERVAL 3600000
+
 #define RTC_CLK_PIN D1
 #define RTC_DAT_PIN D2
 #define RTC_RST_PIN D3
@@ -0,0 +1,123 @@
+#include "FrameStream.h"
+#include "LEDMatrixDevice.h"
+#include "Compositor.h"
+#include "Config.h"
+
+// DDP header
+static const uint8_t DDP_HEADER_SIZE = 10;
+static const uint8_t DDP_TIMECODE_SIZE = 4;
+static const uint8_t DDP_VERSION_MASK = 0xC0;
+static const uint8_t DDP_VERSION_1 = 0x40;
+static const uint8_t DDP_FLAG_TIMECODE = 0x10;
+static const uint8_t DDP_FLAG_PUSH = 0x01;
+
+// m_frameBytes of a frame with a missing part, no offset matches it
+static const uint16_t FRAME_INCOMPLETE = 0xFFFF;
+
+
+FrameStream::FrameStream( LEDMatrixDevice *device ) :
+  m_device(device)
+{
+}
+
+
+void FrameStream::begin( uint16_t port )
+{
+  m_started = m_udp.begin(port);
+  Serial.printf("Stream: listening on UDP port %d ... %s\n", port, m_started ? "ok" : "failed");
+}
+
+
+bool FrameStream::accept( uint8_t sequence )
+{
+  if (sequence == 0) {
+    return true; // The sender does not number packets
+  }
+  if (m_lastSequence == 0) {
+    m_lastSequence = sequence;
+    return true;
+  }
+
+  // Numbers 1-15 wrap around: up to 7 ahead is new, everything else is late or repeated
+  uint8_t ahead = (sequence - m_lastSequence + 15) % 15;
+  if ((ahead == 0) || (ahead > 7)) {
+    return false;
+  }
+  m_lastSequence = sequence;
+  return true;
+}
+
+
+int FrameStream::run()
+{
+  if (!m_started) {
+    return Compositor::IDLE_DELAY;
+  }
+
+  unsigned long now = millis();
+  uint16_t frames = 0;
+
+  int size;
+  while ((size = m_udp.parsePacket()) > 0) {
+    int len = m_udp.read(m_packet, sizeof(m_packet));
+    if ((len < DDP_HEADER_SIZE) || ((m_packet[0] & DDP_VERSION_MASK) != DDP_VERSION_1)) {
+      continue; // Not a DDP packet
+    }
+
+    uint8_t header = DDP_HEADER_SIZE + ((m_packet[0] & DDP_FLAG_TIMECODE) ? DDP_TIMECODE_SIZE : 0);
+    uint32_t offset = ((uint32_t)m_packet[4] << 24) | ((uint32_t)m_packet[5] << 16) | (m_packet[6] << 8) | m_packet[7];
+    uint16_t length = (m_packet[8] << 8) | m_packet[9];
+    if ((len < header + length) || (offset + length > LEDMatrixDevice::FRAME_SIZE)) {
+      m_framesDropped++;
+      continue;
+    }
+
+    // After a pause the sender may have started again with any number
+    if (now - m_lastPacket > STREAM_TIMEOUT) {
+      m_lastSequence = 0;
+    }
+    if (!accept(m_packet[1] & 0x0F)) {
+      m_framesDropped++;
+      continue;
+    }
+    m_lastPacket = now;
+
+    // A frame starts at offset 0 and its parts follow each other. After a gap it can not be complete.
+    if (offset == 0) {
+      m_frameBytes = 0;
+    }
+    if (offset == m_frameBytes) {
+      memcpy(m_frame + offset, m_packet + header, length);
+      m_frameBytes += length;
+    } else {
+      m_frameBytes = FRAME_INCOMPLETE;
+    }
+
+    if (m_packet[0] & DDP_FLAG_PUSH) {
+      // A frame of another size is from a sender set up for another display
+      if (m_frameBytes == LEDMatrixDevice::FRAME_SIZE) {
+        m_device->streamFrame(m_frame, 0, LEDMatrixDevice::FRAME_SIZE, STREAM_TIMEOUT);
+        frames++;
+      } else {
+        m_framesDropped++;
+      }
+      m_frameBytes = 0;
+    }
+  }
+
+  // Only the last of the frames which have been waiting is on the display
+  if (frames > 0) {
+    m_framesShown++;
+    m_framesDropped += frames - 1;
+    m_fpsFrames++;
+  }
+
+  if (now - m_fpsStart >= 1000) {
+    m_fps = m_fpsFrames;
+    m_fpsFrames = 0;
+    m_fpsStart = now;
+  }
+
+  m_active = (m_lastPacket > 0) && (now - m_lastPacket <= STREAM_TIMEOUT);
+  return m_active ? POLL_PERIOD : Compositor::IDLE_DELAY;
+}
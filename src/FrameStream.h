@@ -0,0 +1,77 @@
+#ifndef ESP_INFORMER_FRAME_STREAM_H
+#define ESP_INFORMER_FRAME_STREAM_H
+
+#include <Arduino.h>
+#include <WiFiUdp.h>
+#include "Config.h"
+
+class LEDMatrixDevice;
+
+/*
+ * Receives frames by UDP in the DDP format (http://www.3waylabs.com/ddp/).
+ *
+ * A packet has a 10 byte header (14 with a timecode) followed by pixel data:
+ *   0: flags, version 1 (0x40), timecode (0x10), push (0x01)
+ *   1: sequence number 1-15 in the low 4 bits, 0 - not sequenced
+ *   2: data type, 3: destination id (ignored)
+ *   4-7: offset of the data in the frame (big-endian)
+ *   8-9: length of the data (big-endian)
+ * The frame is the raw frame of LEDMatrixDevice::writeFrame(). A packet with the push flag completes it.
+ * The packets of a frame must cover it in order from offset 0, a frame which is not
+ * LEDMatrixDevice::FRAME_SIZE bytes when it is pushed is dropped.
+ *
+ * A packet with an older or repeated sequence number is dropped. If several frames wait
+ * in the socket, only the newest one is displayed. The device goes back to its content
+ * when no frame arrives for STREAM_TIMEOUT milliseconds.
+ */
+class FrameStream
+{
+public:
+  FrameStream( LEDMatrixDevice *device );
+
+  void begin( uint16_t port );
+
+  /*
+   * Reads the waiting packets. It must be called in loop() before LEDMatrixDevice::run().
+   * Returns amount of milliseconds until it must be called again.
+   */
+  int run();
+
+  /* True while frames are arriving */
+  bool active() const { return m_active; }
+
+  /* Statistics */
+  uint32_t framesShown() const { return m_framesShown; }
+  uint32_t framesDropped() const { return m_framesDropped; }
+  uint16_t fps() const { return m_fps; }
+
+  /* The delay returned by run() while streaming */
+  static const int POLL_PERIOD = 2;
+
+private:
+  /* Returns false if the sequence number is older than the last one or the same */
+  bool accept( uint8_t sequence );
+
+  LEDMatrixDevice *m_device;
+  WiFiUDP m_udp;
+  bool m_started = false;
+  bool m_active = false;
+
+  uint8_t m_packet[512];
+
+  /* The frame being received, m_frameBytes from its start have arrived */
+  uint8_t m_frame[8 * LEDMATRIX_SEGMENTS];
+  uint16_t m_frameBytes = 0;
+  uint8_t m_lastSequence = 0;
+  unsigned long m_lastPacket = 0;
+
+  uint32_t m_framesShown = 0;
+  uint32_t m_framesDropped = 0;
+
+  /* Frames per second over the last second */
+  uint16_t m_fps = 0;
+  uint16_t m_fpsFrames = 0;
+  unsigned long m_fpsStart = 0;
+};
+
+#endif //ESP_INFORMER_FRAME_STREAM_H
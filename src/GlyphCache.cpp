@@ -0,0 +1,79 @@
+#include "GlyphCache.h"
+#include <FS.h>
+#include "Font.h"
+
+// The marker of an empty cache entry
+static const uint16_t NO_CODEPOINT = 0xFFFF;
+
+
+GlyphCache::GlyphCache()
+{
+  for (uint8_t i = 0; i < SIZE; i++) {
+    m_entries[i].codepoint = NO_CODEPOINT;
+    m_entries[i].lastUse = 0;
+  }
+  memset(m_missingPacks, 0, sizeof(m_missingPacks));
+}
+
+
+int GlyphCache::glyphIndex( uint16_t codepoint )
+{
+  for (const GlyphRange &range : fontRanges) {
+    if ((codepoint >= range.first) && (codepoint - range.first < range.count)) {
+      return range.offset + (codepoint - range.first);
+    }
+  }
+  return -1;
+}
+
+
+const uint8_t* GlyphCache::get( uint16_t codepoint )
+{
+  m_clock++;
+
+  // Look for the glyph and for the entry which has not been used for the longest time
+  Entry *victim = &m_entries[0];
+  for (Entry &entry : m_entries) {
+    if (entry.codepoint == codepoint) {
+      entry.lastUse = m_clock;
+      return entry.rows;
+    }
+    if ((entry.codepoint == NO_CODEPOINT) ||
+        ((victim->codepoint != NO_CODEPOINT) && (uint16_t(m_clock - entry.lastUse) > uint16_t(m_clock - victim->lastUse)))) {
+      victim = &entry;
+    }
+  }
+
+  int idx = glyphIndex(codepoint);
+  if (idx >= 0) {
+    memcpy_P(victim->rows, font[idx], 8);
+  } else if (!loadFromPack(codepoint, victim->rows)) {
+    memcpy_P(victim->rows, font[0], 8);
+  }
+
+  victim->codepoint = codepoint;
+  victim->lastUse = m_clock;
+  return victim->rows;
+}
+
+
+bool GlyphCache::loadFromPack( uint16_t codepoint, uint8_t *rows )
+{
+  uint8_t block = codepoint >> 8;
+  if (m_missingPacks[block >> 3] & (1 << (block & 7))) {
+    return false;
+  }
+
+  char path[16];
+  sprintf(path, "/glyphs/%02X.bin", block);
+  File pack = SPIFFS.open(path, "r");
+  if (!pack) {
+    // Do not look for the file again
+    m_missingPacks[block >> 3] |= (1 << (block & 7));
+    return false;
+  }
+
+  bool loaded = pack.seek((codepoint & 0xFF) * 8) && (pack.read(rows, 8) == 8);
+  pack.close();
+  return loaded;
+}
@@ -0,0 +1,47 @@
+#ifndef ESP_INFORMER_GLYPH_CACHE_H
+#define ESP_INFORMER_GLYPH_CACHE_H
+
+#include <Arduino.h>
+
+/*
+ * A RAM cache of the glyphs which are in use (least recently used are evicted).
+ *
+ * Glyphs come from the font in flash. Other code points are loaded from glyph packs
+ * on SPIFFS: the file /glyphs/XX.bin holds the block U+XX00 - U+XXFF, 8 bytes per
+ * code point in order. A code point without a glyph is drawn as a space.
+ */
+class GlyphCache
+{
+public:
+  GlyphCache();
+
+  static const uint8_t SIZE = 32;
+
+  /*
+   * Returns the 8x8 bitmap of a code point (one byte per row).
+   * The pointer is valid until the next call.
+   */
+  const uint8_t* get( uint16_t codepoint );
+
+  /* Returns the index of the glyph in the font in flash, or -1 if the font does not have it */
+  static int glyphIndex( uint16_t codepoint );
+
+private:
+  struct Entry
+  {
+    uint16_t codepoint;
+    uint16_t lastUse;
+    uint8_t rows[8];
+  };
+
+  /* Reads a glyph from its pack. Returns false if there is no pack or no glyph */
+  bool loadFromPack( uint16_t codepoint, uint8_t *rows );
+
+  Entry m_entries[SIZE];
+  uint16_t m_clock = 0;
+
+  /* A bit per block of 256 code points which has no pack on SPIFFS */
+  uint8_t m_missingPacks[32];
+};
+
+#endif //ESP_INFORMER_GLYPH_CACHE_H
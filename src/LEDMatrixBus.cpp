@@ -0,0 +1,104 @@
+#include "LEDMatrixBus.h"
+
+LEDMatrixBus::LEDMatrixBus(uint8_t nsegments, uint8_t ssPin) :
+	m_nsegments(nsegments),
+	m_spiSettings(10000000, MSBFIRST, SPI_MODE0),
+	m_ssPin(ssPin)
+{
+	m_txBuffer = new uint8_t[2*m_nsegments];
+
+	pinMode(m_ssPin, OUTPUT);
+	digitalWrite(m_ssPin, 1);
+	if (m_ssPin < 16) {
+		m_ssMask = 1UL << m_ssPin;
+	}
+	SPI.begin();
+
+	writeRegister(REG_TEST, 0);			      // no test
+	writeRegister(REG_DECODE, 0);			    // No decode mode
+	writeRegister(REG_SCAN_LIMIT, 7);	  // all lines
+
+	setEnabled(false);
+}
+
+LEDMatrixBus::~LEDMatrixBus()
+{
+	if (m_txBuffer) {
+		delete[] m_txBuffer;
+	}
+}
+
+
+void LEDMatrixBus::setEnabled(bool enabled)
+{
+	writeRegister(REG_ENABLE, enabled ? 1 : 0);
+}
+
+/**
+ * Set display intensity
+ *
+ * level:
+ * 	0 - lowest (1/32)
+ * 15 - highest (31/32)
+ */
+
+void LEDMatrixBus::setBrightness(uint8_t level)
+{
+	// Maximum brightness is 0x0F
+	if (level > 0x0F) level = 0x0F;
+	writeRegister(REG_INTENSITY, level);
+}
+
+
+const uint16_t LEDMatrixBus::REGISTER_COMMANDS[REG_COUNT] = {
+	CMD_DECODE,
+	CMD_INTENSITY,
+	CMD_SCAN_LIMIT,
+	CMD_ENABLE,
+	CMD_TEST
+};
+
+
+void LEDMatrixBus::writeRegister(ControlRegister reg, uint8_t value)
+{
+	if ((m_registersKnown & (1 << reg)) && (m_registers[reg] == value)) {
+		return; // Nothing to change
+	}
+
+	m_registers[reg] = value;
+	m_registersKnown |= (1 << reg);
+	tranferCommand(REGISTER_COMMANDS[reg] | value);
+}
+
+
+void LEDMatrixBus::resyncStep()
+{
+	if (!m_registerResync || !m_registersKnown) {
+		return;
+	}
+
+	// Skip registers which have never been written
+	do {
+		m_resyncIndex = (m_resyncIndex + 1) % REG_COUNT;
+	} while (!(m_registersKnown & (1 << m_resyncIndex)));
+
+	tranferCommand(REGISTER_COMMANDS[m_resyncIndex] | m_registers[m_resyncIndex]);
+}
+
+
+void LEDMatrixBus::tranferCommand(uint16_t command)
+{
+	// The same command for all segments
+	for (uint8_t i = 0; i < m_nsegments; i++)
+	{
+		m_txBuffer[2*i] = command >> 8;
+		m_txBuffer[2*i + 1] = command & 0xFF;
+	}
+
+	SPI.beginTransaction(m_spiSettings);
+	// Make the slave listen the master
+	select();
+	SPI.writeBytes(m_txBuffer, 2*m_nsegments);
+	deselect();
+	SPI.endTransaction();
+}
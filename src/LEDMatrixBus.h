@@ -0,0 +1,101 @@
+#ifndef ESP_LED_MATRIX_BUS_H
+#define ESP_LED_MATRIX_BUS_H
+
+#include <Arduino.h>
+#include <SPI.h>
+
+/*
+ * A chain of MAX7219 on the SPI bus: the select slave pin, commands to all segments
+ * and the shadow of the control registers. The framebuffer driver and the streaming
+ * renderer both send through it.
+ */
+class LEDMatrixBus
+{
+	protected:
+		// Commands from the datasheet
+		const static uint16_t CMD_ENABLE = 0x0C00;
+		const static uint16_t CMD_INTENSITY =	0x0A00;
+		const static uint16_t CMD_TEST = 0x0F00;
+		const static uint16_t CMD_SCAN_LIMIT = 0x0B00;
+		const static uint16_t CMD_DECODE = 0x0900;
+		const static uint16_t CMD_NOOP = 0x0000;
+
+	public:
+		// N - Number of segments
+		// ssPin - Select slave pin
+		LEDMatrixBus(uint8_t N, uint8_t ssPin);
+		~LEDMatrixBus();
+
+		LEDMatrixBus(const LEDMatrixBus& other) = delete;
+		LEDMatrixBus& operator=(const LEDMatrixBus& other) = delete;
+
+		// All these commands work on ALL segments.
+		// Values are shadowed, a command which does not change a register is not sent.
+		void setEnabled(bool enabled);
+
+		// Set brightness: 0 - 15
+		void setBrightness(uint8_t level);
+
+		// Re-send one control register after every frame which has sent data, in round-robin,
+		// so the matrixes recover from a brown-out or a glitch without a full re-initialization.
+		// An idle display sends nothing.
+		void setRegisterResync(bool enabled) { m_registerResync = enabled; }
+
+		uint8_t getSegments() const { return m_nsegments; }
+
+	protected:
+		// Shadowed control registers
+		enum ControlRegister : uint8_t
+		{
+			REG_DECODE = 0,
+			REG_INTENSITY,
+			REG_SCAN_LIMIT,
+			REG_ENABLE,
+			REG_TEST,
+			REG_COUNT
+		};
+
+		// Commands of the shadowed registers in the order of ControlRegister
+		static const uint16_t REGISTER_COMMANDS[REG_COUNT];
+
+		// Writes a control register unless the shadow already has the value
+		void writeRegister(ControlRegister reg, uint8_t value);
+
+		// Re-sends the next known control register if the resync is enabled.
+		// It is called after a frame which has sent data.
+		void resyncStep();
+
+		// Transfers a 16-bit word by SPI to all segments
+		void tranferCommand(uint16_t command);
+
+		// Drive the select slave pin. GPIO registers are written directly on ESP8266.
+		void select() {
+#ifdef ESP8266
+			if (m_ssMask) { GPOC = m_ssMask; return; }
+#endif
+			digitalWrite(m_ssPin, 0);
+		}
+
+		void deselect() {
+#ifdef ESP8266
+			if (m_ssMask) { GPOS = m_ssMask; return; }
+#endif
+			digitalWrite(m_ssPin, 1);
+		}
+
+		const uint8_t m_nsegments;
+		SPISettings m_spiSettings;
+		uint8_t m_ssPin;
+		uint32_t m_ssMask = 0;			// GPIO register mask of m_ssPin, 0 for GPIO16
+
+		// Command words of one row for all segments, high byte first
+		uint8_t* m_txBuffer = nullptr;
+
+	private:
+		uint8_t m_registers[REG_COUNT] = {};
+		uint8_t m_registersKnown = 0;		// a bit per register which has been written
+		bool m_registerResync = false;
+		uint8_t m_resyncIndex = 0;
+};
+
+#endif /* ESP_LED_MATRIX_BUS_H */
@@ -0,0 +1,328 @@
+#include "LEDMatrixCanvas.h"
+#include <Arduino.h>
+
+LEDMatrixCanvas::LEDMatrixCanvas(uint16_t width) :
+	m_width(width & ~7),
+	m_columns(width >> 3)
+{
+	m_rowBuffer = new uint8_t[m_columns];
+}
+
+LEDMatrixCanvas::~LEDMatrixCanvas()
+{
+	stopRefresh();
+
+	for (uint8_t i = 0; i < m_nchains; i++) {
+		delete m_chains[i].driver;
+	}
+
+	if (m_rowBuffer) {
+		delete[] m_rowBuffer;
+	}
+}
+
+
+bool LEDMatrixCanvas::addChain(uint8_t ssPin, uint8_t bands, uint8_t flags)
+{
+	if ((m_nchains == MAX_CHAINS) || (bands == 0) || (m_bands + bands > MAX_BANDS) || (bands*m_columns > 255)) {
+		Serial.printf("LEDMatrixCanvas: can not add a chain of %d bands\n", bands);
+		return false;
+	}
+
+	Chain& chain = m_chains[m_nchains++];
+	chain.driver = new LEDMatrixDriver(bands*m_columns, ssPin, flags);
+	chain.firstBand = m_bands;
+	chain.bands = bands;
+	while (bands--) {
+		m_bandChain[m_bands++] = m_nchains - 1;
+	}
+	return true;
+}
+
+
+void LEDMatrixCanvas::setEnabled(bool enabled)
+{
+	for (uint8_t i = 0; i < m_nchains; i++) {
+		m_chains[i].driver->setEnabled(enabled);
+	}
+}
+
+
+void LEDMatrixCanvas::setBrightness(uint8_t level)
+{
+	for (uint8_t i = 0; i < m_nchains; i++) {
+		m_chains[i].driver->setBrightness(level);
+	}
+}
+
+
+void LEDMatrixCanvas::setRegisterResync(bool enabled)
+{
+	for (uint8_t i = 0; i < m_nchains; i++) {
+		m_chains[i].driver->setRegisterResync(enabled);
+	}
+}
+
+
+void LEDMatrixCanvas::setPixel(int16_t x, int16_t y, bool enabled)
+{
+	// Negative coordinates become large unsigned values
+	if ((uint16_t)x >= m_width || (uint16_t)y >= height())
+		return;
+
+	int16_t offset;
+	const Chain* chain = locate(y, offset);
+	chain->driver->setPixel(offset + x, y & 7, enabled);
+}
+
+
+bool LEDMatrixCanvas::getPixel(int16_t x, int16_t y) const
+{
+	if ((uint16_t)x >= m_width || (uint16_t)y >= height())
+		return false;
+
+	int16_t offset;
+	const Chain* chain = locate(y, offset);
+	return chain->driver->getPixel(offset + x, y & 7);
+}
+
+
+void LEDMatrixCanvas::clear()
+{
+	for (uint8_t i = 0; i < m_nchains; i++) {
+		m_chains[i].driver->clear();
+	}
+}
+
+
+void LEDMatrixCanvas::invalidate()
+{
+	for (uint8_t i = 0; i < m_nchains; i++) {
+		m_chains[i].driver->invalidate();
+	}
+}
+
+
+bool LEDMatrixCanvas::isDirty() const
+{
+	for (uint8_t i = 0; i < m_nchains; i++) {
+		if (m_chains[i].driver->isDirty())
+			return true;
+	}
+	return false;
+}
+
+
+uint8_t LEDMatrixCanvas::loadByte(int16_t y, uint16_t column) const
+{
+	int16_t offset;
+	const Chain* chain = locate(y, offset);
+	return chain->driver->loadByte(y & 7, (offset >> 3) + column);
+}
+
+
+void LEDMatrixCanvas::storeByte(int16_t y, uint16_t column, uint8_t value)
+{
+	int16_t offset;
+	const Chain* chain = locate(y, offset);
+	chain->driver->storeByte(y & 7, (offset >> 3) + column, value);
+}
+
+
+void LEDMatrixCanvas::drawSprite( const uint8_t* sprite, int x, int y, int width, int height )
+{
+	if (width > 8) {
+		// Rows are single bytes; pixels beyond the 8th column are cleared as in LEDMatrixDriver
+		for (int iy = 0; iy < height; iy++)
+		{
+			for (int ix = 8; ix < width; ix++)
+			{
+				setPixel(x + ix, y + iy, false);
+			}
+		}
+		width = 8;
+	}
+
+	// Clip at the canvas edges: in a chain the next band continues right of this one
+	uint8_t skip = 0;
+	if (x < 0) {
+		skip = -x < 8 ? -x : 8;
+		width -= skip;
+		x = 0;
+	}
+	if (x + width > m_width)
+		width = m_width - x;
+	if (width <= 0)
+		return;
+
+	for (int iy = 0; iy < height; iy++)
+	{
+		int cy = y + iy;
+		if ((cy < 0) || (cy >= 8*m_bands))
+			continue;
+
+		int16_t offset;
+		const Chain* chain = locate(cy, offset);
+		uint8_t bits = sprite[iy] << skip;
+		chain->driver->drawSprite(&bits, offset + x, cy & 7, width, 1);
+	}
+}
+
+
+void LEDMatrixCanvas::drawString( const char* text, int len, int x, int y )
+{
+	for (int idx = 0; idx < len; idx++)
+	{
+		int cx = x + idx*8;
+		if (cx >= m_width)
+			return;
+		if (cx + 8 > 0)
+			drawSprite(LEDMatrixDriver::glyph((uint8_t)text[idx]), cx, y, 8, 8);
+	}
+}
+
+
+void LEDMatrixCanvas::scroll( LEDMatrixDriver::ScrollDirection direction, uint8_t pixels )
+{
+	int16_t h = height();
+
+	switch (direction)
+	{
+		case LEDMatrixDriver::ScrollDirection::Up:
+			for (int16_t y = 0; y < h; y++)
+			{
+				for (uint16_t column = 0; column < m_columns; column++)
+				{
+					storeByte(y, column, (y + pixels < h) ? loadByte(y + pixels, column) : 0);
+				}
+			}
+			break;
+
+		case LEDMatrixDriver::ScrollDirection::Down:
+			for (int16_t y = h - 1; y >= 0; y--)
+			{
+				for (uint16_t column = 0; column < m_columns; column++)
+				{
+					storeByte(y, column, (y - pixels >= 0) ? loadByte(y - pixels, column) : 0);
+				}
+			}
+			break;
+
+		case LEDMatrixDriver::ScrollDirection::Left:
+		case LEDMatrixDriver::ScrollDirection::Right:
+			for (int16_t y = 0; y < h; y++)
+			{
+				for (uint16_t column = 0; column < m_columns; column++)
+				{
+					m_rowBuffer[column] = loadByte(y, column);
+				}
+
+				if (direction == LEDMatrixDriver::ScrollDirection::Left)
+					LEDMatrixDriver::shiftRowLeft(m_rowBuffer, m_columns, pixels);
+				else
+					LEDMatrixDriver::shiftRowRight(m_rowBuffer, m_columns, pixels);
+
+				for (uint16_t column = 0; column < m_columns; column++)
+				{
+					storeByte(y, column, m_rowBuffer[column]);
+				}
+			}
+			break;
+	}
+}
+
+
+void LEDMatrixCanvas::display()
+{
+	if (m_refreshActive) {
+		// The timer sends it
+		for (uint8_t i = 0; i < m_nchains; i++) {
+			m_chains[i].driver->commit();
+		}
+		return;
+	}
+
+	if (pushFrame(false)) {
+		for (uint8_t i = 0; i < m_nchains; i++) {
+			m_chains[i].driver->resyncStep();
+		}
+	}
+}
+
+
+bool LEDMatrixCanvas::pushFrame(bool front)
+{
+	uint8_t rows = 0;
+	for (uint8_t i = 0; i < m_nchains; i++) {
+		LEDMatrixDriver* d = m_chains[i].driver;
+		rows |= front ? d->m_frontDirtyRows : d->m_dirtyRows;
+	}
+	if (rows == 0) {
+		return false; // Nothing has changed since the last call
+	}
+
+	uint32_t start = micros();
+
+	// The chains share the bus, so a row of every chain goes out before the next row
+	SPI.beginTransaction(m_chains[0].driver->m_spiSettings);
+	for (uint8_t y = 0; y < 8; y++)
+	{
+		if (!(rows & (1 << y)))
+			continue;
+
+		for (uint8_t i = 0; i < m_nchains; i++)
+		{
+			LEDMatrixDriver* d = m_chains[i].driver;
+			if (front && (d->m_frontDirtyRows & (1 << y)))
+				d->sendRow(d->m_frontBuffer, d->m_frontDirtySegments, y);
+			else if (!front && (d->m_dirtyRows & (1 << y)))
+				d->sendRow(d->m_frameBuffer, d->m_dirtySegments, y);
+		}
+	}
+	SPI.endTransaction();
+
+	for (uint8_t i = 0; i < m_nchains; i++) {
+		LEDMatrixDriver* d = m_chains[i].driver;
+		(front ? d->m_frontDirtyRows : d->m_dirtyRows) = 0;
+	}
+
+	m_displayMicros = micros() - start;
+	return true;
+}
+
+
+void LEDMatrixCanvas::startRefresh(uint16_t intervalMillis)
+{
+	for (uint8_t i = 0; i < m_nchains; i++) {
+		m_chains[i].driver->attachFrontBuffer();
+	}
+
+	m_refreshActive = true;
+	m_refreshTicker.attach_ms(intervalMillis, refreshCallback, this);
+}
+
+
+void LEDMatrixCanvas::stopRefresh()
+{
+	if (!m_refreshActive) {
+		return;
+	}
+
+	m_refreshTicker.detach();
+	m_refreshActive = false;
+
+	// Every chain gets back its framebuffer with everything marked as changed
+	for (uint8_t i = 0; i < m_nchains; i++) {
+		m_chains[i].driver->stopRefresh();
+	}
+}
+
+
+void LEDMatrixCanvas::refreshCallback(LEDMatrixCanvas* canvas)
+{
+	if (canvas->pushFrame(true)) {
+		for (uint8_t i = 0; i < canvas->m_nchains; i++) {
+			canvas->m_chains[i].driver->resyncStep();
+		}
+	}
+}
@@ -0,0 +1,111 @@
+#ifndef ESP_LED_MATRIX_CANVAS_H
+#define ESP_LED_MATRIX_CANVAS_H
+
+#include "LEDMatrixDriver.h"
+
+/*
+ * A virtual canvas of width x height pixels on several chains of MAX7219 modules.
+ *
+ * The canvas is split into bands of 8 pixel rows, one row of modules each.
+ * A chain covers one or more consecutive bands: its segments go band by band,
+ * width/8 segments per band. Every chain has its own select slave pin on the same SPI bus.
+ *
+ * Frames are sent interleaved in one SPI transaction: row 0 of every chain,
+ * then row 1 of every chain, ... so all chains change at the same time.
+ *
+ * The canvas is a library class for sketches which drive taller panels. The informer
+ * renders one band through LEDMatrixDriver* and does not use it.
+ */
+class LEDMatrixCanvas
+{
+	public:
+		const static uint8_t MAX_CHAINS = 4;
+		const static uint8_t MAX_BANDS = 16;
+
+		// width - width of the canvas in pixels, a multiple of 8
+		LEDMatrixCanvas(uint16_t width);
+		~LEDMatrixCanvas();
+
+		LEDMatrixCanvas(const LEDMatrixCanvas& other) = delete;
+		LEDMatrixCanvas& operator=(const LEDMatrixCanvas& other) = delete;
+
+		// Adds a chain of bands rows of modules below the previous chains.
+		// Returns false if there are too many chains or bands, or more than 255 segments in the chain.
+		bool addChain(uint8_t ssPin, uint8_t bands, uint8_t flags = 0);
+
+		uint16_t width() const { return m_width; }
+		uint16_t height() const { return 8*m_bands; }
+
+		uint8_t chainCount() const { return m_nchains; }
+		LEDMatrixDriver* chain(uint8_t index) const { return m_chains[index].driver; }
+
+		// All these commands work on all chains
+		void setEnabled(bool enabled);
+		void setBrightness(uint8_t level);
+		void setRegisterResync(bool enabled);
+
+		void setPixel(int16_t x, int16_t y, bool enabled);
+		bool getPixel(int16_t x, int16_t y) const;
+
+		void clear();
+		void invalidate();
+		bool isDirty() const;
+
+		// Draws a sprite (one byte per row, MSB is the leftmost pixel), it may cross bands
+		void drawSprite( const uint8_t* sprite, int x, int y, int width, int height );
+		void drawString( const char* text, int len, int x, int y );
+
+		// Scrolls the whole canvas, pixels move between bands and chains
+		void scroll( LEDMatrixDriver::ScrollDirection direction, uint8_t pixels = 1 );
+
+		// Writes the changed rows of all chains in one interleaved SPI transaction
+		void display();
+
+		// Duration of the last frame push which has sent data, in microseconds
+		uint32_t displayMicros() const { return m_displayMicros; }
+
+		// Pushes the front buffers of all chains from one timer, see LEDMatrixDriver::startRefresh()
+		void startRefresh(uint16_t intervalMillis);
+		void stopRefresh();
+		bool refreshActive() const { return m_refreshActive; }
+
+	private:
+		struct Chain
+		{
+			LEDMatrixDriver* driver;
+			uint8_t firstBand;
+			uint8_t bands;
+		};
+
+		// Returns the chain of the canvas row y and the x offset of its band in the chain
+		const Chain* locate(int16_t y, int16_t& offset) const {
+			const Chain* chain = &m_chains[m_bandChain[y >> 3]];
+			offset = ((y >> 3) - chain->firstBand)*m_width;
+			return chain;
+		}
+
+		// Read and write 8 pixels of a canvas row (MSB is the leftmost pixel)
+		uint8_t loadByte(int16_t y, uint16_t column) const;
+		void storeByte(int16_t y, uint16_t column, uint8_t value);
+
+		// Sends the dirty rows of the back or front buffers of all chains.
+		// Returns false if there was nothing to send.
+		bool pushFrame(bool front);
+
+		static void refreshCallback(LEDMatrixCanvas* canvas);
+
+		const uint16_t m_width;
+		const uint16_t m_columns;			// bytes per canvas row
+		Chain m_chains[MAX_CHAINS] = {};
+		uint8_t m_bandChain[MAX_BANDS] = {};	// the chain of every band
+		uint8_t m_nchains = 0;
+		uint8_t m_bands = 0;
+
+		uint8_t* m_rowBuffer = nullptr;	// a canvas row used by scroll()
+
+		Ticker m_refreshTicker;
+		bool m_refreshActive = false;
+		uint32_t m_displayMicros = 0;
+};
+
+#endif /* ESP_LED_MATRIX_CANVAS_H */
@@ -1,16 +1,35 @@
 #include "LEDMatrixDevice.h"
 #include <string>
+#include "Utf8.h"
 
 #include "DS1302RTC.h" // https://github.com/iot-playground/Arduino/tree/master/external_libraries/DS1302RTC
+#include "SoftClock.h"
 
-LEDMatrixDevice::LEDMatrixDevice()
+LEDMatrixDevice::LEDMatrixDevice() :
+  m_clockZone(SoftClock::now),
+  m_transition(LEDMATRIX_SEGMENTS)
 {
-  m_driver = new LEDMatrixDriver(LEDMATRIX_SEGMENTS, LEDMATRIX_CS_PIN, LEDMatrixDriver::INVERT_DISPLAY_X | LEDMatrixDriver::INVERT_SEGMENT_X | LEDMatrixDriver::INVERT_Y );
+#if defined(LEDMATRIX_STREAMING)
+  m_stream = new LEDMatrixStream(LEDMATRIX_SEGMENTS, LEDMATRIX_CS_PIN, LEDMATRIX_FLAGS);
+  m_bus = m_stream;
+#else
+  m_driver = new LEDMatrixDriver(LEDMATRIX_SEGMENTS, LEDMATRIX_CS_PIN, LEDMATRIX_FLAGS);
+  m_bus = m_driver;
+#endif
   m_rtc = new DS1302RTC( RTC_RST_PIN, RTC_DAT_PIN,  RTC_CLK_PIN ); //CE, IO, CLK
+  // The display reads the time from the software clock, the RTC is read only to sync it
+  SoftClock::begin(RTC_SYNC_INTERVAL);
 
-  m_driver->setEnabled(true);
-  m_driver->setBrightness(m_brightness); // 0 = low, 15 = high
+  m_bus->setEnabled(true);
+  m_bus->setBrightness(m_brightness); // 0 = low, 15 = high
+  m_bus->setRegisterResync(true);
+#ifndef LEDMATRIX_STREAMING
   m_driver->clear();
+  m_driver->setDitherPeriod(LEDMATRIX_DITHER_PERIOD);
+  if (LEDMATRIX_REFRESH_INTERVAL > 0) {
+    m_driver->startRefresh(LEDMATRIX_REFRESH_INTERVAL);
+  }
+#endif
 
   m_displayState = DisplayState::Time;
 }
@@ -22,51 +41,164 @@ LEDMatrixDevice::~LEDMatrixDevice()
     delete m_rtc;
   }
 
+#ifdef LEDMATRIX_STREAMING
+  if (m_stream) {
+    delete m_stream;
+  }
+#else
   if (m_driver) {
     delete m_driver;
   }
+#endif
 }
 
 
-void LEDMatrixDevice::setNotification( const std::vector<byte> &icon, const std::string &text, int timeout )
+void LEDMatrixDevice::setNotification( const AnimatedIcon &icon, const char *text, int timeout, FontStyle font,
+                                       const NotificationOptions &options )
 {
-  std::shared_ptr<Notification> ntf = std::make_shared<Notification>();
-  ntf->icon = std::move(icon);
-  ntf->text = std::move(text);
-  if (timeout > 0) {
-    ntf->timeout = timeout;
+  bool wasEmpty = m_notificationQueue.empty();
+  bool showing = !wasEmpty && (m_displayState == DisplayState::Notification);
+  const Notification *front = wasEmpty ? nullptr : &m_notificationQueue.front();
+
+  Notification *ntf = m_notificationQueue.find(options.key);
+  if (ntf && !(showing && (ntf == &m_notificationQueue.front()))) {
+    // A queued notification with the key is replaced, the new one takes its place by priority
+    m_notificationQueue.remove(ntf);
+    ntf = nullptr;
   }
 
-  if ( m_notificationQueue.empty() ) {
-    m_driver->clear();
-    m_textX = ntf->icon.size();
-    if (timeout > 0) {
-      m_notificationTimerTimeoutMilliseconds = timeout * 1000;
-      m_notificationTimerActive = true;
+  if (ntf == nullptr) {
+    // The notification on the display stays unless a more urgent one preempts it
+    bool keepFront = showing && !(options.preempt && (options.priority > m_notificationQueue.front().priority));
+    ntf = m_notificationQueue.insert(options.priority, keepFront);
+    if (ntf == nullptr) {
+      Serial.printf("Device: the notification queue is full (%d), the notification is dropped\n", NotificationQueue::CAPACITY);
+      return;
     }
-    m_displayState = DisplayState::Notification;
   }
 
-  m_notificationQueue.push(ntf); // Notification in the queue
+  ntf->icon = icon;
+  ntf->textLength = decodeUtf8(text, ntf->text, MESSAGE_TEXT_CAPACITY);
+  ntf->font = font;
+  ntf->timeout = timeout > 0 ? timeout : 0;
+  ntf->priority = options.priority;
+  ntf->expires = 0;
+  if (options.ttl > 0) {
+    // 0 means never
+    ntf->expires = millis() + options.ttl * 1000;
+    ntf->expires += (ntf->expires == 0);
+  }
+  strncpy(ntf->key, options.key ? options.key : "", NOTIFICATION_KEY_CAPACITY - 1);
 
+  // A new or updated front is displayed, a queue behind a raw frame waits for it.
+  // A preempting notification can also move a queued one of a higher priority to the front.
+  bool frontChanged = (front != &m_notificationQueue.front());
+  if (wasEmpty || (showing && (frontChanged || (ntf == &m_notificationQueue.front())))) {
+    showNotification();
+  }
 }
 
 
-void LEDMatrixDevice::setScreen( uint8_t id, const std::vector<byte> &icon, const std::string &text )
+void LEDMatrixDevice::showNotification()
 {
-  for (auto screen : m_screenList) {
-    if (screen->id == id) {
-      screen->icon = std::move(icon);
-      screen->text = std::string(text);
-      return;
-    }
+  const Notification &ntf = m_notificationQueue.front();
+  m_notificationTimerTimeoutMilliseconds = ntf.timeout * 1000UL;
+  m_notificationTimerActive = (ntf.timeout > 0);
+  m_notificationTimerStart = 0;
+  m_displayState = DisplayState::Notification;
+  requestLayout();
+}
+
+
+void LEDMatrixDevice::setScreen( uint8_t id, const AnimatedIcon &icon, const char *text, FontStyle font )
+{
+  // The slot is rewritten in place
+  Screen *screen = m_screens.insert(id);
+  if (screen == nullptr) {
+    Serial.printf("Device: ERROR: screen %d is rejected, all %d screens are taken (SCREEN_CAPACITY in Config.h)\n", id, ScreenTable::CAPACITY);
+    return;
+  }
+  screen->icon = icon;
+  screen->textLength = decodeUtf8(text, screen->text, MESSAGE_TEXT_CAPACITY);
+  screen->font = font;
+
+  // The screen is being displayed: lay out the new text
+  if ((m_displayState == DisplayState::Screen) && (m_screens.position(id) == m_screenIndex)) {
+    requestLayout();
+  }
+}
+
+
+void LEDMatrixDevice::writeFrame( const uint8_t *data, size_t index, size_t len, size_t total )
+{
+#ifdef LEDMATRIX_STREAMING
+  if (index == 0) {
+    Serial.println("Device: raw frames need the framebuffer, the frame is dropped in the streaming mode");
+  }
+#else
+  if ((total != FRAME_SIZE) && (total != FRAME_SIZE + 2)) {
+    Serial.printf("Device: a frame must have %d or %d bytes, received %d\n", FRAME_SIZE, FRAME_SIZE + 2, total);
+    return;
+  }
+
+  if ((index == 0) && (m_displayState != DisplayState::Frame)) {
+    // The frame replaces the content at once, the zones are removed before it is written
+    m_transition.cancel(m_driver, m_brightness);
+    m_driver->clearGreyscale();
+    m_compositor.clear(m_driver);
+    m_layoutChanged = false;
+    m_layoutState = DisplayState::Frame;
+    m_displayState = DisplayState::Frame;
+    m_screenTimerActive = false;
+    m_screenTimerStart = 0;
+    // An interrupted notification waits in the queue, its timer starts again when it comes back
+    m_notificationTimerActive = false;
+    m_notificationTimerStart = 0;
+  } else if (m_displayState != DisplayState::Frame) {
+    return; // The frame has been replaced while its parts were arriving
+  }
+
+  bool lastPart = (index + len >= total);
+  if (index == 0) {
+    m_frameHold = 0;
+  }
+
+  // Copy the rows of the part to the framebuffer
+  size_t offset = index;
+  while ((len > 0) && (offset < FRAME_SIZE)) {
+    uint8_t column = offset % LEDMATRIX_SEGMENTS;
+    uint8_t count = len < (size_t)(LEDMATRIX_SEGMENTS - column) ? len : LEDMATRIX_SEGMENTS - column;
+    m_driver->writeRow(offset / LEDMATRIX_SEGMENTS, data, column, count);
+    offset += count;
+    data += count;
+    len -= count;
+  }
+
+  // The hold time follows the frame
+  for (; len > 0; len--) {
+    m_frameHold = (m_frameHold << 8) | *data++;
+  }
+
+  if (lastPart) {
+    m_frameHoldMilliseconds = m_frameHold * 1000UL;
+    m_frameTimerActive = (m_frameHold > 0);
+    m_frameTimerStart = 0;
   }
+#endif
+}
 
-  std::shared_ptr<Screen> scr = std::make_shared<Screen>();
-  scr->id = id;
-  scr->icon = std::move(icon);
-  scr->text = std::move(text);
-  m_screenList.push_back(scr);
+
+void LEDMatrixDevice::streamFrame( const uint8_t *data, size_t offset, size_t len, unsigned long timeout )
+{
+  writeFrame(data, offset, len, FRAME_SIZE);
+#ifdef LEDMATRIX_STREAMING
+  return;
+#endif
+
+  // Every part moves the fallback further
+  m_frameHoldMilliseconds = timeout;
+  m_frameTimerActive = true;
+  m_frameTimerStart = millis();
 }
 
 
@@ -80,6 +212,7 @@ void LEDMatrixDevice::setTime( uint8_t hour, uint8_t minute, uint8_t second, uin
   tm.Month = month;
   tm.Year = year;
   m_rtc->write(tm);
+  SoftClock::set(makeTime(tm));
 }
 
 
@@ -87,14 +220,14 @@ void LEDMatrixDevice::setBrightness( uint8_t brightness )
 {
   if ( brightness >= 0 && brightness <= 15 ) {
     m_brightness = brightness;
-    m_driver->setBrightness(brightness);
+    m_bus->setBrightness(brightness);
   }
 }
 
 
 void LEDMatrixDevice::setState( const bool state )
 {
-  m_driver->clear();
+  requestLayout();
   m_state = state;
   m_displayState = state ? DisplayState::Time : DisplayState::None;
   m_switchOffAfterNotification = (m_displayState == DisplayState::None);
@@ -103,27 +236,44 @@ void LEDMatrixDevice::setState( const bool state )
 
 void LEDMatrixDevice::setSecondsVisible( const bool secondsVisible )
 {
-  m_driver->clear();
+  requestLayout();
   m_secondsVisible = secondsVisible;
 }
 
 
+void LEDMatrixDevice::setClockFont( FontStyle font )
+{
+  requestLayout();
+  m_clockFont = font;
+}
+
+
+void LEDMatrixDevice::setClockZoneVisible( const bool visible )
+{
+  requestLayout();
+  m_clockZoneVisible = visible;
+}
+
+
 void LEDMatrixDevice::buttonClicked()
 {
   if (m_displayState == DisplayState::Notification) {
     this->dismissNotification();
-  } else if ((m_displayState == DisplayState::Time) && (m_screenList.size() > 0)) {
+  } else if (m_displayState == DisplayState::Frame) {
+    dismissFrame();
+  } else if ((m_displayState == DisplayState::Time) && !m_screens.empty()) {
     m_displayState = DisplayState::Screen;
     m_screenTimerActive = true;
     m_screenTimerStart = millis();
-    m_driver->clear();
-  } else if ( (m_screenIndex == (m_screenList.size() - 1)) && (m_displayState == DisplayState::Screen) ) {
+    requestLayout();
+  } else if ( (m_screenIndex == (m_screens.size() - 1)) && (m_displayState == DisplayState::Screen) ) {
     dismissScreen();
-  } else if ((m_displayState == DisplayState::Screen) && (m_screenList.size() > 1)) {
+  } else if ((m_displayState == DisplayState::Screen) && (m_screens.size() > 1)) {
     dismissScreen();
     m_displayState = DisplayState::Screen;
     m_screenTimerActive = true;
     m_screenTimerStart = millis();
+    requestLayout();
   }
 }
 
@@ -134,17 +284,147 @@ void LEDMatrixDevice::buttonPressAndHold()
 }
 
 
+#ifdef LEDMATRIX_STREAMING
+
+void LEDMatrixDevice::applyLayout( unsigned long now )
+{
+  m_layoutChanged = false;
+  m_layoutState = m_displayState;
+  m_stream->clearList();
+  m_streamClock = NO_ITEM;
+  m_streamClockText[0] = '\0';
+  m_streamScrolling = false;
+
+  if (m_displayState == DisplayState::Time) {
+    m_clockZone.setRect(0, LEDMATRIX_WIDTH);
+    m_clockZone.configure(m_clockFont, m_secondsVisible, true);
+    m_streamClock = m_stream->addText(m_clockZone.x(), m_clockZone.width(), m_clockFont);
+  } else if (m_displayState == DisplayState::Screen) {
+    const Screen &screen = m_screens.at(m_screenIndex);
+    layoutContent(screen.icon, screen.text, screen.textLength, screen.font, now);
+  } else if (m_displayState == DisplayState::Notification) {
+    const Notification &notification = m_notificationQueue.front();
+    layoutContent(notification.icon, notification.text, notification.textLength, notification.font, now);
+  } else if (m_displayState == DisplayState::None) {
+    // A pixel tells that the display is off
+    static const uint8_t offIcon[8] = { 0x80 };
+    m_stream->addIcon(0, offIcon);
+  }
+}
+
+
+void LEDMatrixDevice::layoutContent( const AnimatedIcon &icon, const char16_t *text, uint8_t len, FontStyle font, unsigned long now )
+{
+  // The same places as the zones: the icon, a small clock on the right side and the text
+  int textX = 0;
+  if (!icon.empty()) {
+    m_stream->addIcon(0, icon.frame());
+    textX = 8;
+  }
+
+  int textEnd = LEDMATRIX_WIDTH;
+  if (m_clockZoneVisible) {
+    int clockWidth = Typeface::textWidth(FontStyle::Compact, u"00:00", 5);
+    textEnd -= clockWidth;
+    m_clockZone.setRect(textEnd, clockWidth);
+    m_clockZone.configure(FontStyle::Compact, false, false);
+    m_streamClock = m_stream->addText(textEnd, clockWidth, FontStyle::Compact);
+  }
+
+  uint8_t item = m_stream->addText(textX, textEnd - textX, font, Marquee::PIXEL_PERIOD);
+  m_stream->setText(item, text, len, now);
+  m_streamScrolling = Typeface::textWidth(font, text, len) > textEnd - textX;
+}
+
+
+unsigned long LEDMatrixDevice::updateStreamClock( unsigned long now )
+{
+  if (m_streamClock == NO_ITEM) {
+    return 1000;
+  }
+
+  uint16_t ms;
+  time_t t = SoftClock::now(ms);
+  char buf[9];
+  int len = m_clockZone.format(buf, t, ms);
+  if (strcmp(buf, m_streamClockText) != 0) {
+    strcpy(m_streamClockText, buf);
+    char16_t text[8];
+    for (int idx = 0; idx < len; idx++) {
+      text[idx] = buf[idx];
+    }
+    m_stream->setText(m_streamClock, text, len, now);
+  }
+  return m_clockZone.period() - ms % m_clockZone.period();
+}
+
+#else
+
+void LEDMatrixDevice::applyLayout( unsigned long now )
+{
+  if (m_displayState == DisplayState::Frame) {
+    // The frame is in the framebuffer already
+    m_layoutChanged = false;
+    return;
+  }
+
+  m_layoutChanged = false;
+  m_layoutState = m_displayState;
+  m_compositor.clear(m_driver);
+
+  if (m_displayState == DisplayState::Time) {
+    m_clockZone.setRect(0, LEDMATRIX_WIDTH);
+    m_clockZone.configure(m_clockFont, m_secondsVisible, true);
+    m_compositor.addZone(&m_clockZone);
+  } else if (m_displayState == DisplayState::Screen) {
+    const Screen &screen = m_screens.at(m_screenIndex);
+    layoutContent(screen.icon, screen.text, screen.textLength, screen.font, now);
+  } else if (m_displayState == DisplayState::Notification) {
+    const Notification &notification = m_notificationQueue.front();
+    layoutContent(notification.icon, notification.text, notification.textLength, notification.font, now);
+  }
+}
+
+
+void LEDMatrixDevice::layoutContent( const AnimatedIcon &icon, const char16_t *text, uint8_t len, FontStyle font, unsigned long now )
+{
+  // The icon takes the first segment, a small clock the right side, the text gets the rest
+  int textX = 0;
+  if (!icon.empty()) {
+    m_iconZone.setRect(0, 8);
+    m_iconZone.setIcon(icon);
+    m_compositor.addZone(&m_iconZone);
+    textX = 8;
+  }
+
+  int textEnd = LEDMATRIX_WIDTH;
+  if (m_clockZoneVisible) {
+    int clockWidth = Typeface::textWidth(FontStyle::Compact, u"00:00", 5);
+    textEnd -= clockWidth;
+    m_clockZone.setRect(textEnd, clockWidth);
+    m_clockZone.configure(FontStyle::Compact, false, false);
+    m_compositor.addZone(&m_clockZone);
+  }
+
+  m_textZone.setRect(textX, textEnd - textX);
+  m_textZone.setText(text, len, font, now);
+  m_compositor.addZone(&m_textZone);
+}
+
+#endif
+
+
 void LEDMatrixDevice::dismissScreen()
 {
   // Reset timer's parameters
   m_screenTimerStart = 0;
   m_screenTimerActive = false;
 
-  m_screenIndex = m_screenIndex < (m_screenList.size() - 1) ? m_screenIndex + 1 : 0;
+  m_screenIndex = m_screenIndex < (m_screens.size() - 1) ? m_screenIndex + 1 : 0;
 
   if (m_displayState != DisplayState::Notification) {
     m_displayState = DisplayState::Time;
-    m_driver->clear();
+    requestLayout();
   }
 }
 
@@ -156,27 +436,64 @@ void LEDMatrixDevice::dismissNotification()
   m_notificationTimerStart = 0;
   m_notificationTimerActive = false;
 
-  // Release notification memory: remove the element from the queue
+  // The record goes back to the pool
   m_notificationQueue.pop();
 
+  // Expired notifications are not displayed
+  m_notificationQueue.removeExpired(millis(), false);
+
   if ( m_notificationQueue.empty() ) {
     m_displayState = m_switchOffAfterNotification ? DisplayState::None : DisplayState::Time;
+    requestLayout();
   } else {
-    m_displayState = DisplayState::Notification;
-    // Prepare the screen and the timer for the next notification in the queue
-    m_textX = 0;
-    if (m_notificationQueue.front()->timeout > 0) {
-      m_notificationTimerTimeoutMilliseconds = m_notificationQueue.front()->timeout * 1000;
-      m_notificationTimerActive = true;
-    }
+    // The next notification in the queue, its zones are laid out in run()
+    showNotification();
   }
+}
 
-  m_driver->clear();
+
+void LEDMatrixDevice::dismissFrame()
+{
+  m_frameTimerActive = false;
+  m_frameTimerStart = 0;
+
+  // Queued notifications come first, with the whole timeout
+  if (!m_notificationQueue.empty()) {
+    showNotification();
+  } else {
+    m_displayState = m_state ? DisplayState::Time : DisplayState::None;
+    requestLayout();
+  }
+}
+
+
+void LEDMatrixDevice::measureLoad( float &spiDuty, float &headroom )
+{
+  uint32_t now = micros();
+  uint32_t elapsed = now - m_loadStart;
+#ifdef LEDMATRIX_STREAMING
+  // Rows are generated while they are sent, and there are no display timers
+  uint32_t spiMicros = m_stream->spiMicros();
+  uint32_t timerMicros = 0;
+#else
+  uint32_t spiMicros = m_driver->spiMicros();
+  uint32_t timerMicros = m_driver->timerMicros();
+#endif
+  uint32_t spi = spiMicros - m_loadSpiMicros;
+  uint32_t busy = m_runMicros + timerMicros - m_loadBusyMicros;
+
+  spiDuty = elapsed ? 100.0f * spi / elapsed : 0;
+  headroom = elapsed ? 100.0f - 100.0f * busy / elapsed : 100;
+
+  m_loadStart = now;
+  m_loadSpiMicros = spiMicros;
+  m_loadBusyMicros = m_runMicros + timerMicros;
 }
 
 
 int LEDMatrixDevice::run()
 {
+  uint32_t runStart = micros();
   int returnDelay = 0;
   if ((m_notificationTimerStart == 0) && (m_notificationTimerActive)) {
     m_notificationTimerStart = millis();
@@ -186,70 +503,82 @@ int LEDMatrixDevice::run()
     m_screenTimerStart = millis();
   }
 
-  if (m_displayState == DisplayState::Time)
-  {
-    time_t myTime = m_rtc->get();
-    char buf[8];
-    if (m_secondsVisible) {
-      std::sprintf( buf, "%02d:%02d:%02d", hour(myTime), minute(myTime), second(myTime) );
-      m_driver->drawString(buf, 8, 0, 0);
-      returnDelay = 500;
-    } else {
-      if (m_secondDelimiterVisible) {
-        std::sprintf( buf, "%02d:%02d", hour(myTime), minute(myTime) );
-      } else {
-        std::sprintf( buf, "%02d %02d", hour(myTime), minute(myTime) );
-      }
-      m_secondDelimiterVisible = !m_secondDelimiterVisible;
-      m_driver->drawString(buf, 5, 13, 0);
-      returnDelay = 1000;
-    }
+  if ((m_frameTimerStart == 0) && (m_frameTimerActive)) {
+    m_frameTimerStart = millis();
   }
-  else if (m_displayState == DisplayState::Screen)
-  {
-    bool iconExists = m_screenList.at(m_screenIndex)->icon.size() > 0;
-    uint8_t screenLength = iconExists ? LEDMATRIX_SEGMENTS - 1 : LEDMATRIX_SEGMENTS;
-    const char *text = m_screenList.at(m_screenIndex)->text.c_str();
-    int textLength = m_screenList.at(m_screenIndex)->text.length();
 
-    if (textLength > screenLength) {
-      m_textX = (m_textX < -8 * textLength + 8 * iconExists) ? LEDMATRIX_WIDTH : (m_textX - 1);
-    } else {
-      m_textX = (screenLength - textLength) * 8 / 2 + 8 * iconExists;
-    }
+  SoftClock::run();
+  unsigned long now = millis();
 
-    m_driver->drawString( text, textLength, m_textX, 0 );
-    if (iconExists) {
-      m_driver->drawSprite(m_screenList.at(m_screenIndex)->icon.data(), 0, 0, 8, 8);
+  /* Expired notifications are dropped, the one on the display is dismissed */
+  if (!m_notificationQueue.empty()) {
+    bool showing = (m_displayState == DisplayState::Notification);
+    m_notificationQueue.removeExpired(now, showing);
+    if (showing && NotificationQueue::expired(m_notificationQueue.front(), now)) {
+      dismissNotification();
     }
+  }
 
-    returnDelay = (textLength > screenLength ? 50 : 300);
+#ifdef LEDMATRIX_STREAMING
+  if (m_layoutChanged) {
+    applyLayout(now);
   }
-  else if (m_displayState == DisplayState::Notification)
-  {
-    bool iconExists = m_notificationQueue.front()->icon.size() > 0;
-    uint8_t screenLength = iconExists ? LEDMATRIX_SEGMENTS - 1 : LEDMATRIX_SEGMENTS;
-    const char *text = m_notificationQueue.front()->text.c_str();
-    int textLength = m_notificationQueue.front()->text.length();
 
-    if (textLength > screenLength) {
-      m_textX = (m_textX < -8 * textLength + 8 * iconExists) ? LEDMATRIX_WIDTH : (m_textX - 1);
+  // The rows are generated from the display list when the frame is sent below
+  returnDelay = updateStreamClock(now);
+  if (m_streamScrolling && (returnDelay > (int)Marquee::PIXEL_PERIOD)) {
+    returnDelay = Marquee::PIXEL_PERIOD;
+  }
+#else
+  if (m_layoutChanged) {
+    // The icon zone of the new layout dithers its icon again when it is drawn
+    m_driver->clearGreyscale();
+
+    // A change between two visible layouts is animated
+    bool animate = (m_transition.effect() != Transition::Effect::None) &&
+                   (m_layoutState != DisplayState::None) && (m_displayState != DisplayState::None) &&
+                   (m_displayState != DisplayState::Frame);
+    if (animate) {
+      m_transition.captureOutgoing(m_driver);
     } else {
-      m_textX = (screenLength - textLength) * 8 / 2 + 8 * iconExists;
+      m_transition.cancel(m_driver, m_brightness);
+    }
+
+    applyLayout(now);
+
+    if (animate) {
+      m_compositor.render(m_driver, now);
+      m_transition.start(m_driver, now);
+      // Dithering would draw over the transition until the zones take over
+      m_driver->clearGreyscale();
     }
+  }
 
-    m_driver->drawString(text, textLength, m_textX, 0);
-    if (iconExists) {
-      m_driver->drawSprite(m_notificationQueue.front()->icon.data(), 0, 0, 8, 8);
+  bool transitionRunning = false;
+  if (m_transition.active()) {
+    transitionRunning = m_transition.step(m_driver, now, m_brightness);
+    if (!transitionRunning) {
+      // The new frame is on the display, its zones take over from here
+      m_compositor.restart(now);
     }
+  }
 
-    returnDelay = (textLength > screenLength ? 50 : 300);
+  if (transitionRunning)
+  {
+    // The zones wait for the end of the transition
+    returnDelay = Transition::STEP_PERIOD;
   }
-  else
+  else if (m_displayState == DisplayState::None)
   {
     m_driver->setPixel(0, 0, true);
     returnDelay = 1000;
   }
+  else
+  {
+    // Only zones which are due are drawn
+    returnDelay = m_compositor.render(m_driver, now);
+  }
+#endif
 
   /* The notification timer */
   if ( ((millis() - m_notificationTimerStart) >= m_notificationTimerTimeoutMilliseconds) &&
@@ -257,6 +586,12 @@ int LEDMatrixDevice::run()
     dismissNotification();
   }
 
+  /* The frame timer */
+  if ( ((millis() - m_frameTimerStart) >= m_frameHoldMilliseconds) &&
+      (m_frameTimerStart > 0) && m_frameTimerActive && (m_displayState == DisplayState::Frame)) {
+    dismissFrame();
+  }
+
   /* The screen timer */
   if ( ((millis() - m_screenTimerStart) >= m_screenTimerTimeoutMilliseconds) &&
       (m_screenTimerStart > 0) && m_screenTimerActive) {
@@ -264,7 +599,24 @@ int LEDMatrixDevice::run()
     m_screenIndex = 0;
   }
 
-  m_driver->display();
+#ifdef LEDMATRIX_STREAMING
+  m_stream->display(millis());
+#else
+  // A new second goes to the display at once, not with the next refresh
+  if (m_clockZone.tickPending()) {
+    m_driver->flush();
+    m_clockZone.tickPushed();
+  } else {
+    m_driver->display();
+  }
+#endif
+
+  // A due sync of the clock waits for the next second boundary
+  unsigned long untilSync = SoftClock::untilSync();
+  if (untilSync < (unsigned long)returnDelay) {
+    returnDelay = untilSync;
+  }
 
+  m_runMicros += micros() - runStart;
   return returnDelay;
 }
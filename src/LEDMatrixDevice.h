@@ -1,29 +1,23 @@
 #ifndef ESP_LED_MATRIX_DEVICE_H
 #define ESP_LED_MATRIX_DEVICE_H
 
-#include <queue>
-#include <vector>
-#include <memory>
 #include "Config.h"
 
 #include "LEDMatrixDriver.h"
+#include "Typeface.h"
+#include "Zone.h"
+#include "Compositor.h"
+#include "Transition.h"
+#include "AnimatedIcon.h"
+#include "ScreenTable.h"
+#include "NotificationQueue.h"
+
+#ifdef LEDMATRIX_STREAMING
+#include "LEDMatrixStream.h"
+#endif
 
 class DS1302RTC;
 
-struct Notification
-{
-  std::vector<byte> icon;
-  std::string text;
-  int timeout;
-};
-
-struct Screen
-{
-  uint8_t id;
-  std::vector<byte> icon;
-  std::string text;
-};
-
 class LEDMatrixDevice
 {
 public:
@@ -35,12 +29,30 @@ public:
     None,
     Time,
     Screen,
-    Notification
+    Notification,
+    Frame
   };
 
+  /* A raw frame: 8 logical rows of LEDMATRIX_SEGMENTS bytes, MSB of the first byte is the leftmost pixel */
+  static const size_t FRAME_SIZE = 8 * LEDMATRIX_SEGMENTS;
+
   void setTime( uint8_t hour, uint8_t minute, uint8_t second, uint8_t day, uint8_t month, uint16_t year );
-  void setNotification( const std::vector<byte> &icon, const std::string &text, int timeout = -1 );
-  void setScreen( uint8_t id, const std::vector<byte> &icon, const std::string &text );
+  void setNotification( const AnimatedIcon &icon, const char *text, int timeout = -1, FontStyle font = FontStyle::Fixed,
+                        const NotificationOptions &options = NotificationOptions() );
+  void setScreen( uint8_t id, const AnimatedIcon &icon, const char *text, FontStyle font = FontStyle::Fixed );
+
+  /*
+   * Writes a part of a raw frame straight into the framebuffer. The payload is FRAME_SIZE bytes,
+   * optionally followed by the hold time in seconds (16 bits, big-endian, 0 - until the button is clicked).
+   * data has len bytes at index of total bytes, the frame is shown when the last part has arrived.
+   */
+  void writeFrame( const uint8_t *data, size_t index, size_t len, size_t total );
+
+  /*
+   * Writes a part of a streamed frame at offset. The device returns to its content
+   * if no part arrives within timeout milliseconds.
+   */
+  void streamFrame( const uint8_t *data, size_t offset, size_t len, unsigned long timeout );
 
   /*
    * Run the device. Returns amount of milliseconds to delay
@@ -53,11 +65,36 @@ public:
   bool state() const { return m_state; }
   uint8_t brightness() const { return m_brightness; }
   bool secondsVisible() const { return m_secondsVisible; }
+  FontStyle clockFont() const { return m_clockFont; }
+  bool clockZoneVisible() const { return m_clockZoneVisible; }
+#ifdef LEDMATRIX_STREAMING
+  uint32_t displayMicros() const { return m_stream->displayMicros(); }
+#else
+  uint32_t displayMicros() const { return m_driver->displayMicros(); }
+#endif
+  uint8_t queuedNotifications() const { return m_notificationQueue.size(); }
+  uint32_t droppedNotifications() const { return m_notificationQueue.dropped(); }
+  uint8_t screenCount() const { return m_screens.size(); }
+  uint32_t rejectedScreens() const { return m_screens.rejected(); }
+
+  /*
+   * Load since the previous call, in percent: time of SPI transfers (spiDuty) and time
+   * which is left to the loop after rendering and the display timers (headroom).
+   */
+  void measureLoad( float &spiDuty, float &headroom );
+
+  /* Milliseconds the clock ticked after the second boundary since the previous call: the average and the maximum */
+  void measureClockJitter( float &average, uint16_t &maximum ) { m_clockZone.measureLateness(average, maximum); }
 
   /* Setters */
   void setState( const bool state );
   void setBrightness( uint8_t brightness );
   void setSecondsVisible( const bool secondsVisible );
+  void setClockFont( FontStyle font );
+  void setClockZoneVisible( const bool visible );
+  void setTransitionEffect( Transition::Effect effect ) { m_transition.setEffect(effect); }
+  void setTransitionDuration( unsigned long duration ) { m_transition.setDuration(duration); }
+  void setTransitionEasing( Transition::Easing easing ) { m_transition.setEasing(easing); }
 
   /* Button's callbacks */
   void buttonClicked();
@@ -67,31 +104,80 @@ private:
   void dismissScreen();
   void dismissNotification();
 
+  /* Displays the first notification of the queue and starts its timer */
+  void showNotification();
+  void dismissFrame();
+
+  /* The zones are laid out again for the display state on the next run() */
+  void requestLayout() { m_layoutChanged = true; }
+  void applyLayout( unsigned long now );
+
+  /* Lays out the zones of a screen or a notification */
+  void layoutContent( const AnimatedIcon &icon, const char16_t *text, uint8_t len, FontStyle font, unsigned long now );
+
+#ifdef LEDMATRIX_STREAMING
+  /* Sets the text of the clock item to the time of the clock zone. Returns milliseconds until it changes */
+  unsigned long updateStreamClock( unsigned long now );
+#endif
+
   /* Properties */
   bool m_state = true;
   uint8_t m_brightness = 5;
   bool m_secondsVisible = true;
-  bool m_secondDelimiterVisible = true;
+  FontStyle m_clockFont = FontStyle::Fixed;
+  bool m_clockZoneVisible = false;
 
   /* Devices */
+#ifdef LEDMATRIX_STREAMING
+  /* The zones are laid out as items of the display list, the clock zone keeps the settings of the clock */
+  static const uint8_t NO_ITEM = 0xFF;
+  LEDMatrixStream *m_stream = nullptr;
+  uint8_t m_streamClock = NO_ITEM;
+  char m_streamClockText[9] = {};
+  bool m_streamScrolling = false;
+#else
   LEDMatrixDriver *m_driver = nullptr;
+#endif
+  LEDMatrixBus *m_bus = nullptr;        // the driver or the stream, for the control registers
   DS1302RTC *m_rtc = nullptr;
 
   /* Displaying information */
   DisplayState m_displayState = DisplayState::None;
   bool m_switchOffAfterNotification = false;
 
+  /* Zones of the display */
+  Compositor m_compositor;
+  IconZone m_iconZone;
+  TextZone m_textZone;
+  ClockZone m_clockZone;
+  bool m_layoutChanged = true;
+  DisplayState m_layoutState = DisplayState::None;   // the state the zones are laid out for
+
+  /* Changes of the layout are animated */
+  Transition m_transition;
+
   /* Notifications */
-  int m_textX = 0;
-  std::queue<std::shared_ptr<Notification>> m_notificationQueue;
+  NotificationQueue m_notificationQueue;
 
   /* Notification timer */
   bool m_notificationTimerActive = false;
   unsigned long m_notificationTimerStart = 0;
   unsigned long m_notificationTimerTimeoutMilliseconds = 0;
 
+  /* Raw frame */
+  bool m_frameTimerActive = false;
+  unsigned long m_frameTimerStart = 0;
+  unsigned long m_frameHoldMilliseconds = 0;
+  uint16_t m_frameHold = 0;             // seconds, received after the frame
+
+  /* Load: time spent in run(), and the counters at the previous measureLoad() */
+  uint32_t m_runMicros = 0;
+  uint32_t m_loadStart = 0;
+  uint32_t m_loadSpiMicros = 0;
+  uint32_t m_loadBusyMicros = 0;
+
   /* Screen */
-  std::vector<std::shared_ptr<Screen>> m_screenList;
+  ScreenTable m_screens;
   uint8_t m_screenIndex = 0;
 
   bool m_screenTimerActive = false;
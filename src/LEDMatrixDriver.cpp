@@ -1,37 +1,67 @@
 #include "LEDMatrixDriver.h"
 #include <Arduino.h>
 
-#include "Font.h"
+#include "GlyphCache.h"
+
+// Glyphs of the font in flash which have been used recently
+static GlyphCache glyphCache;
 
 LEDMatrixDriver::LEDMatrixDriver(uint8_t nsegments, uint8_t ssPin, uint8_t flags, uint8_t* fb) :
-	m_nsegments(nsegments),
-	m_spiSettings(10000000, MSBFIRST, SPI_MODE0),
+	LEDMatrixBus(nsegments, ssPin),
 	m_flags(flags),
-	m_frameBuffer(fb),
-	m_ssPin(ssPin)
+	m_frameBuffer(fb)
 {
 	if (fb == nullptr) {
 		m_frameBuffer = new uint8_t[m_nsegments*8];
+		m_ownsFrameBuffer = true;
 	}
 
-	clear();
+	if (m_flags & WIRE_ORDER) {
+		m_invertRows = m_flags & INVERT_Y;
+		m_invertColumns = m_flags & INVERT_DISPLAY_X;
+		m_reverseBits = m_flags & INVERT_SEGMENT_X;
+	}
 
-	pinMode(m_ssPin, OUTPUT);
-	digitalWrite(m_ssPin, 1);
-	SPI.begin();
+	m_rowBuffer = new uint8_t[m_nsegments];
 
-	tranferCommand(LEDMatrixDriver::CMD_TEST);			      // no test
-	tranferCommand(LEDMatrixDriver::CMD_DECODE);			    // No decode mode
-	tranferCommand(LEDMatrixDriver::CMD_SCAN_LIMIT | 7);	// all lines
+	m_dirtyStride = (m_nsegments + 7) >> 3;
+	m_dirtySegments = new uint8_t[m_dirtyStride*8];
+	memset(m_dirtySegments, 0, m_dirtyStride*8);
 
-	setEnabled(false);
+	clear();
+	// The content of the MAX7219 registers is unknown after power-up
+	invalidate();
 }
 
 LEDMatrixDriver::~LEDMatrixDriver()
 {
-	if (m_frameBuffer) {
+	stopRefresh();
+	m_ditherTicker.detach();
+
+	// An external frame buffer belongs to the caller
+	if (m_frameBuffer && m_ownsFrameBuffer) {
 		delete[] m_frameBuffer;
 	}
+
+	if (m_dirtySegments) {
+		delete[] m_dirtySegments;
+	}
+
+	if (m_rowBuffer) {
+		delete[] m_rowBuffer;
+	}
+
+	if (m_frontBuffer) {
+		delete[] m_frontBuffer;
+	}
+
+	if (m_frontDirtySegments) {
+		delete[] m_frontDirtySegments;
+	}
+
+	if (m_greyPlanes) {
+		delete[] m_greyPlanes;
+	}
 }
 
 
@@ -39,11 +69,12 @@ void LEDMatrixDriver::setPixel(int16_t x, int16_t y, bool enabled)
 {
 	uint8_t* p = getPixelsBytePtr(x, y);
 	if (p) {
-		uint16_t b = 7 - (x & 7);		// Create a mask to get the required bit
-		if (enabled)
-			*p |=  (1<<b);
-		else
-			*p &= ~(1<<b);
+		uint8_t mask = pixelMask(x);
+		uint8_t value = enabled ? (*p | mask) : (*p & ~mask);
+		if (value != *p) {
+			*p = value;
+			markDirty(bufferRow(y), bufferColumn(x >> 3));
+		}
 	}
 }
 
@@ -55,8 +86,7 @@ bool LEDMatrixDriver::getPixel(int16_t x, int16_t y) const
 		return false;
 	}
 
-	uint16_t b = 7 - (x & 7); // Create a mask to check the required bit
-	return *p & (1 << b);
+	return *p & pixelMask(x);
 }
 
 
@@ -70,76 +100,144 @@ void LEDMatrixDriver::setColumn(int16_t x, uint8_t value)
 	}
 }
 
-void LEDMatrixDriver::setEnabled(bool enabled)
+uint8_t LEDMatrixDriver::reverseByte(uint8_t b) {
+   b = (b & 0xF0) >> 4 | (b & 0x0F) << 4;
+   b = (b & 0xCC) >> 2 | (b & 0x33) << 2;
+   b = (b & 0xAA) >> 1 | (b & 0x55) << 1;
+	 return b;
+}
+
+void LEDMatrixDriver::clear()
+{
+	for (uint8_t row = 0; row < 8; row++) {
+		for (uint8_t column = 0; column < m_nsegments; column++) {
+			writeByte(row, column, 0);
+		}
+	}
+}
+
+
+void LEDMatrixDriver::invalidate()
 {
-	tranferCommand(CMD_ENABLE | (enabled ? 1 : 0));
+	memset(m_dirtySegments, 0xFF, m_dirtyStride*8);
+	m_dirtyRows = 0xFF;
 }
 
-/**
- * Set display intensity
- *
- * level:
- * 	0 - lowest (1/32)
- * 15 - highest (31/32)
- */
 
-void LEDMatrixDriver::setBrightness(uint8_t level)
+void LEDMatrixDriver::writeByte(uint8_t row, uint8_t column, uint8_t value)
 {
-	// Maximum brightness is 0x0F
-	if (level > 0x0F) level = 0x0F;
-	tranferCommand(CMD_INTENSITY | level);
+	uint8_t& b = m_frameBuffer[row*m_nsegments + column];
+	if (b != value) {
+		b = value;
+		markDirty(row, column);
+	}
 }
 
 
-void LEDMatrixDriver::tranferCommand(uint16_t command)
+void LEDMatrixDriver::writeBufferRow(uint8_t row, const uint8_t* bytes)
 {
-	SPI.beginTransaction(m_spiSettings);
-	// Make the slave listen the master
-	digitalWrite(m_ssPin, 0);
-	// Send the same command to all segments
-	for (uint8_t i = 0; i < m_nsegments; i++)
+	uint8_t* dst = m_frameBuffer + row*m_nsegments;
+	for (uint8_t column = 0; column < m_nsegments; column++)
 	{
-		SPI.transfer16(command);
+		if (dst[column] != bytes[column]) {
+			dst[column] = bytes[column];
+			markDirty(row, column);
+		}
 	}
-	digitalWrite(m_ssPin, 1);
-	SPI.endTransaction();
 }
 
-uint8_t LEDMatrixDriver::reverseByte(uint8_t b) {
-   b = (b & 0xF0) >> 4 | (b & 0x0F) << 4;
-   b = (b & 0xCC) >> 2 | (b & 0x33) << 2;
-   b = (b & 0xAA) >> 1 | (b & 0x55) << 1;
-	 return b;
+
+uint8_t LEDMatrixDriver::loadByte(uint8_t y, uint8_t column) const
+{
+	uint8_t b = m_frameBuffer[bufferRow(y)*m_nsegments + bufferColumn(column)];
+	return m_reverseBits ? reverseByte(b) : b;
 }
 
-void LEDMatrixDriver::displayRow(uint8_t row)
+
+void LEDMatrixDriver::storeByte(uint8_t y, uint8_t column, uint8_t value)
+{
+	writeByte(bufferRow(y), bufferColumn(column), m_reverseBits ? reverseByte(value) : value);
+}
+
+
+void LEDMatrixDriver::readRow(uint8_t y, uint8_t* bytes) const
 {
-	// Calculates row address based on flags
-	uint8_t address_row = m_flags & INVERT_Y ? 7 - row: row;
+	for (uint8_t column = 0; column < m_nsegments; column++)
+		bytes[column] = loadByte(y, column);
+}
 
-	bool display_x_inverted = m_flags & INVERT_DISPLAY_X;
-	bool segment_x_inverted = m_flags & INVERT_SEGMENT_X;
 
-	//for x inverted display change iterating order
-	//inverting segments may still be needed!
-	int16_t from = display_x_inverted ? m_nsegments-1:  0;		// start from ...
-	int16_t to =   display_x_inverted ? -1  : m_nsegments;		// where to stop
-	int16_t step = display_x_inverted ? -1 :  1;		        // directon
+void LEDMatrixDriver::writeRow(uint8_t y, const uint8_t* bytes)
+{
+	writeRow(y, bytes, 0, m_nsegments);
+}
+
+
+void LEDMatrixDriver::writeRow(uint8_t y, const uint8_t* bytes, uint8_t column, uint8_t count)
+{
+	for (uint8_t i = 0; i < count && column + i < m_nsegments; i++)
+		storeByte(y, column + i, bytes[i]);
+}
+
+
+void LEDMatrixDriver::displayRow(uint8_t row)
+{
+	encodeRow(m_frameBuffer, nullptr, row);
 
 	SPI.beginTransaction(m_spiSettings);
-	digitalWrite(m_ssPin, 0);
+	select();
+	SPI.writeBytes(m_txBuffer, 2*m_nsegments);
+	deselect();
+	SPI.endTransaction();
 
-	for (int16_t d = from; d != to; d += step)
+	clearDirtyRow(row);
+}
+
+
+void LEDMatrixDriver::encodeRow(const uint8_t* buffer, const uint8_t* dirtySegments, uint8_t row)
+{
+	uint8_t* tx = m_txBuffer;
+
+	if (m_flags & WIRE_ORDER)
 	{
-		uint8_t data = m_frameBuffer[d + row*m_nsegments];
-		if (segment_x_inverted)
-			data = reverseByte(data);
-		uint16_t cmd = ((address_row + 1) << 8) | data;
-		SPI.transfer16(cmd);
+		// The buffer is already in transmit order, so every word is the row address and a stored byte
+		uint8_t address = row + 1;
+		const uint8_t* data = buffer + row*m_nsegments;
+		for (uint8_t d = 0; d < m_nsegments; d++)
+		{
+			// A segment which has not changed gets a no-op and keeps its register value
+			bool send = !dirtySegments || isSegmentDirty(dirtySegments, row, d);
+			*tx++ = send ? address : 0;
+			*tx++ = send ? data[d] : 0;
+		}
+	}
+	else
+	{
+		// Calculates row address based on flags
+		uint8_t address_row = m_flags & INVERT_Y ? 7 - row: row;
+
+		bool display_x_inverted = m_flags & INVERT_DISPLAY_X;
+		bool segment_x_inverted = m_flags & INVERT_SEGMENT_X;
+
+		//for x inverted display change iterating order
+		//inverting segments may still be needed!
+		int16_t from = display_x_inverted ? m_nsegments-1:  0;		// start from ...
+		int16_t to =   display_x_inverted ? -1  : m_nsegments;		// where to stop
+		int16_t step = display_x_inverted ? -1 :  1;		        // directon
+
+		for (int16_t d = from; d != to; d += step)
+		{
+			uint16_t cmd = CMD_NOOP;
+			if (!dirtySegments || isSegmentDirty(dirtySegments, row, d)) {
+				uint8_t data = buffer[d + row*m_nsegments];
+				if (segment_x_inverted)
+					data = reverseByte(data);
+				cmd = ((address_row + 1) << 8) | data;
+			}
+			*tx++ = cmd >> 8;
+			*tx++ = cmd & 0xFF;
+		}
 	}
-
-	digitalWrite(m_ssPin, 1);
-	SPI.endTransaction();
 }
 
 
@@ -152,34 +250,418 @@ uint8_t* LEDMatrixDriver::getPixelsBytePtr(int16_t x, int16_t y) const
 
 	uint16_t B = x >> 3;		// Devide by 8
 
-	return m_frameBuffer + y*m_nsegments + B;
+	return m_frameBuffer + bufferRow(y)*m_nsegments + bufferColumn(B);
 }
 
 
 void LEDMatrixDriver::display()
 {
+	if (m_refreshActive) {
+		commit(); // The timer sends it
+		return;
+	}
+
+	if (pushFrame(m_frameBuffer, m_dirtySegments, m_dirtyRows)) {
+		resyncStep();
+	}
+}
+
+
+bool LEDMatrixDriver::pushFrame(const uint8_t* buffer, uint8_t* dirtySegments, uint8_t& dirtyRows)
+{
+	if (dirtyRows == 0) {
+		return false; // Nothing has changed since the last call
+	}
+
+	uint32_t start = micros();
+
+	// One transaction for the frame, one burst from the SPI FIFO for every row.
+	// MAX7219 latches a row on the rising edge of the select slave pin.
+	SPI.beginTransaction(m_spiSettings);
 	for (uint8_t y = 0; y < 8; y++)
 	{
-		displayRow(y);
+		if (dirtyRows & (1 << y)) {
+			sendRow(buffer, dirtySegments, y);
+		}
+	}
+	SPI.endTransaction();
+	dirtyRows = 0;
+
+	m_displayMicros = micros() - start;
+	m_spiMicros += m_displayMicros;
+	return true;
+}
+
+
+void LEDMatrixDriver::sendRow(const uint8_t* buffer, uint8_t* dirtySegments, uint8_t row)
+{
+	encodeRow(buffer, dirtySegments, row);
+	select();
+	SPI.writeBytes(m_txBuffer, 2*m_nsegments);
+	deselect();
+	memset(dirtySegments + row*m_dirtyStride, 0, m_dirtyStride);
+}
+
+
+void LEDMatrixDriver::startRefresh(uint16_t intervalMillis)
+{
+	attachFrontBuffer();
+	m_refreshTicker.attach_ms(intervalMillis, refreshCallback, this);
+}
+
+
+void LEDMatrixDriver::attachFrontBuffer()
+{
+	if (m_frontBuffer == nullptr) {
+		m_frontBuffer = new uint8_t[m_nsegments*8];
+		m_frontDirtySegments = new uint8_t[m_dirtyStride*8];
+	}
+
+	// The front buffer starts as the current frame with all pending changes
+	memcpy(m_frontBuffer, m_frameBuffer, m_nsegments*8);
+	memcpy(m_frontDirtySegments, m_dirtySegments, m_dirtyStride*8);
+	m_frontDirtyRows = m_dirtyRows;
+	memset(m_dirtySegments, 0, m_dirtyStride*8);
+	m_dirtyRows = 0;
+
+	m_refreshActive = true;
+}
+
+
+void LEDMatrixDriver::stopRefresh()
+{
+	if (!m_refreshActive) {
+		return;
+	}
+
+	m_refreshTicker.detach();
+	m_refreshActive = false;
+
+	// The display gets the last rendered frame from loop() from now on
+	invalidate();
+}
+
+
+void LEDMatrixDriver::commit()
+{
+	for (uint8_t row = 0; row < 8; row++)
+	{
+		if (!(m_dirtyRows & (1 << row)))
+			continue;
+
+		for (uint8_t column = 0; column < m_nsegments; column++)
+		{
+			if (isSegmentDirty(row, column)) {
+				m_frontBuffer[row*m_nsegments + column] = m_frameBuffer[row*m_nsegments + column];
+			}
+		}
+		for (uint8_t i = 0; i < m_dirtyStride; i++)
+		{
+			m_frontDirtySegments[row*m_dirtyStride + i] |= m_dirtySegments[row*m_dirtyStride + i];
+		}
+		clearDirtyRow(row);
+		m_frontDirtyRows |= (1 << row);
 	}
 }
 
 
-void LEDMatrixDriver::scroll( ScrollDirection direction )
+void LEDMatrixDriver::flush()
+{
+	display();
+	if (m_refreshActive && pushFrame(m_frontBuffer, m_frontDirtySegments, m_frontDirtyRows)) {
+		resyncStep();
+	}
+}
+
+
+void LEDMatrixDriver::refreshCallback(LEDMatrixDriver* driver)
+{
+	uint32_t start = micros();
+	if (driver->pushFrame(driver->m_frontBuffer, driver->m_frontDirtySegments, driver->m_frontDirtyRows)) {
+		driver->resyncStep();
+	}
+	driver->m_timerMicros += micros() - start;
+}
+
+
+void LEDMatrixDriver::setGreyscale(uint8_t column, uint8_t count, const uint8_t* high, const uint8_t* low)
+{
+	if (column >= m_nsegments || count == 0) {
+		clearGreyscale();
+		return;
+	}
+	if (column + count > m_nsegments) {
+		count = m_nsegments - column;
+	}
+
+	// The planes are allocated with the first greyscale image, for the whole width
+	if (m_greyPlanes == nullptr) {
+		m_greyPlanes = new uint8_t[16*m_nsegments];
+	}
+
+	// Rows of the previous image may be showing its dim plane
+	markGreyscaleDirty();
+
+	m_greyColumn = column;
+	m_greyCount = count;
+	m_greyRows = 0;
+	for (uint8_t y = 0; y < 8; y++)
+	{
+		writeRow(y, high + y*count, column, count);
+		if (memcmp(high + y*count, low + y*count, count) != 0) {
+			m_greyRows |= (1 << y);
+		}
+	}
+	memcpy(m_greyPlanes, high, 8*count);
+	memcpy(m_greyPlanes + 8*count, low, 8*count);
+
+	if (m_greyRows && m_ditherPeriod) {
+		m_greyPhase = 0;
+		m_ditherTicker.attach_ms(m_ditherPeriod, ditherCallback, this);
+	} else {
+		m_ditherTicker.detach();
+	}
+}
+
+
+void LEDMatrixDriver::clearGreyscale()
+{
+	if (m_greyCount == 0) {
+		return;
+	}
+
+	m_ditherTicker.detach();
+	markGreyscaleDirty();
+	m_greyCount = 0;
+	m_greyRows = 0;
+}
+
+
+void LEDMatrixDriver::markGreyscaleDirty()
+{
+	for (uint8_t y = 0; y < 8; y++)
+	{
+		if (m_greyRows & (1 << y)) {
+			for (uint8_t i = 0; i < m_greyCount; i++)
+				markDirty(bufferRow(y), bufferColumn(m_greyColumn + i));
+		}
+	}
+}
+
+
+void LEDMatrixDriver::ditherCallback(LEDMatrixDriver* driver)
+{
+	uint8_t phase = driver->m_greyPhase;
+	driver->m_greyPhase = phase == 2 ? 0 : phase + 1;
+
+	// The bright plane stays on the display for the second sub-frame
+	if (phase == 1) {
+		return;
+	}
+
+	uint32_t start = micros();
+	const uint8_t* plane = driver->m_greyPlanes + (phase == 0 ? 0 : 8*driver->m_greyCount);
+
+	SPI.beginTransaction(driver->m_spiSettings);
+	for (uint8_t y = 0; y < 8; y++)
+	{
+		if (driver->m_greyRows & (1 << y)) {
+			driver->sendGreyscaleRow(y, plane + y*driver->m_greyCount);
+		}
+	}
+	SPI.endTransaction();
+
+	uint32_t elapsed = micros() - start;
+	driver->m_spiMicros += elapsed;
+	driver->m_timerMicros += elapsed;
+}
+
+
+void LEDMatrixDriver::sendGreyscaleRow(uint8_t y, const uint8_t* bytes)
+{
+	// The same orientation for both layouts of the framebuffer: the address of the logical row
+	// and the position of the segment in the chain
+	uint8_t address = (m_flags & INVERT_Y ? 7 - y : y) + 1;
+
+	memset(m_txBuffer, 0, 2*m_nsegments);
+	for (uint8_t i = 0; i < m_greyCount; i++)
+	{
+		uint8_t column = m_greyColumn + i;
+		uint8_t position = m_flags & INVERT_DISPLAY_X ? m_nsegments - 1 - column : column;
+		m_txBuffer[2*position] = address;
+		m_txBuffer[2*position + 1] = m_flags & INVERT_SEGMENT_X ? reverseByte(bytes[i]) : bytes[i];
+	}
+
+	select();
+	SPI.writeBytes(m_txBuffer, 2*m_nsegments);
+	deselect();
+}
+
+
+// Big-endian 32-bit access: the leftmost pixel is the MSB of the word.
+// Bytes are assembled one by one as the framebuffer rows are not word aligned.
+static inline uint32_t loadWord(const uint8_t* p)
+{
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline void storeWord(uint8_t* p, uint32_t w)
+{
+	p[0] = w >> 24;
+	p[1] = w >> 16;
+	p[2] = w >> 8;
+	p[3] = w;
+}
+
+
+void LEDMatrixDriver::shiftRowLeft( const uint8_t* src, uint8_t* dst, uint8_t n, uint16_t pixels )
+{
+	uint16_t bytes = pixels >> 3;
+	uint8_t bits = pixels & 7;
+	if (bytes >= n) {
+		memset(dst, 0, n);
+		return;
+	}
+
+	// Output byte i takes its pixels from the source bytes i+bytes and i+bytes+1.
+	// Going from left to right never overwrites a source byte which is still needed.
+	uint8_t count = n - bytes;
+	uint8_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const uint8_t* s = src + i + bytes;
+		uint32_t next = (i + bytes + 4 < n) ? s[4] : 0;
+		uint32_t w = loadWord(s);
+		if (bits)
+			w = (w << bits) | (next >> (8 - bits));
+		storeWord(dst + i, w);
+	}
+	for (; i < count; i++)
+	{
+		uint16_t s = i + bytes;
+		uint8_t next = (s + 1 < n) ? src[s + 1] : 0;
+		dst[i] = bits ? (src[s] << bits) | (next >> (8 - bits)) : src[s];
+	}
+	memset(dst + count, 0, bytes);
+}
+
+
+void LEDMatrixDriver::shiftRowRight( const uint8_t* src, uint8_t* dst, uint8_t n, uint16_t pixels )
+{
+	uint16_t bytes = pixels >> 3;
+	uint8_t bits = pixels & 7;
+	if (bytes >= n) {
+		memset(dst, 0, n);
+		return;
+	}
+
+	// Output byte i takes its pixels from the source bytes i-bytes-1 and i-bytes.
+	// Going from right to left never overwrites a source byte which is still needed.
+	int16_t i = n;
+	for (; i - 4 >= (int16_t)bytes; i -= 4)
+	{
+		const uint8_t* s = src + i - 4 - bytes;
+		uint32_t prev = (i - 4 - (int16_t)bytes > 0) ? s[-1] : 0;
+		uint32_t w = loadWord(s);
+		if (bits)
+			w = (w >> bits) | (prev << (32 - bits));
+		storeWord(dst + i - 4, w);
+	}
+	for (i = i - 1; i >= (int16_t)bytes; i--)
+	{
+		int16_t s = i - bytes;
+		uint8_t prev = (s > 0) ? src[s - 1] : 0;
+		dst[i] = bits ? (src[s] >> bits) | (prev << (8 - bits)) : src[s];
+	}
+	memset(dst, 0, bytes);
+}
+
+
+void LEDMatrixDriver::scroll( ScrollDirection direction, uint8_t pixels )
 {
-	int cnt = 0;
 	switch( direction )
 	{
 		case ScrollDirection::Up:
-			cnt = 7*(m_nsegments);	// moving 7 rows of N segments
-			memmove(m_frameBuffer, m_frameBuffer + m_nsegments, cnt);
-			memset(m_frameBuffer+cnt, 0, m_nsegments);		// Clear last row
+		case ScrollDirection::Down:
+		{
+			// A logical row is a whole framebuffer row in every layout, rows are moved as they are
+			memset(m_rowBuffer, 0, m_nsegments);
+			bool up = (direction == ScrollDirection::Up);
+			for (int i = 0; i < 8; i++)
+			{
+				int y = up ? i : 7 - i;
+				int from = up ? y + pixels : y - pixels;
+				const uint8_t* src = (from >= 0 && from < 8) ? m_frameBuffer + bufferRow(from)*m_nsegments : m_rowBuffer;
+				writeBufferRow(bufferRow(y), src);
+			}
+			break;
+		}
+
+		case ScrollDirection::Left:
+		case ScrollDirection::Right:
+		{
+			// With both the segments and their bits in reverse order, a framebuffer row is the
+			// logical row mirrored, and it is shifted the other way. With neither it is the logical row.
+			bool mirrored = m_invertColumns && m_reverseBits;
+			bool direct = mirrored || (!m_invertColumns && !m_reverseBits);
+			bool left = (direction == ScrollDirection::Left) != mirrored;
+			for (int y = 0; y < 8; y++)
+			{
+				const uint8_t* src = m_frameBuffer + y*m_nsegments;
+				if (!direct) {
+					readRow(y, m_rowBuffer);
+					src = m_rowBuffer;
+				}
+
+				if (left)
+					shiftRowLeft(src, m_rowBuffer, m_nsegments, pixels);
+				else
+					shiftRowRight(src, m_rowBuffer, m_nsegments, pixels);
+
+				// Only bytes which have actually changed are marked for the display
+				if (direct)
+					writeBufferRow(y, m_rowBuffer);
+				else
+					writeRow(y, m_rowBuffer);
+			}
+			break;
+		}
+	}
+}
+
+
+void LEDMatrixDriver::scrollReference( ScrollDirection direction )
+{
+	switch( direction )
+	{
+		case ScrollDirection::Up:
+			// moving 7 rows of N segments
+			for (int y = 0; y < 7; y++)
+			{
+				for (int x = 0; x < m_nsegments; x++)
+				{
+					storeByte(y, x, loadByte(y + 1, x));
+				}
+			}
+			for (int x = 0; x < m_nsegments; x++)
+			{
+				storeByte(7, x, 0);		// Clear last row
+			}
 			break;
 
 		case ScrollDirection::Down:
-			cnt = 7*m_nsegments; // moving 7 rows of m_nsegments segments
-			memmove(m_frameBuffer+m_nsegments, m_frameBuffer, cnt);
-			memset(m_frameBuffer, 0, m_nsegments);		// Clear first row
+			// moving 7 rows of N segments
+			for (int y = 7; y > 0; y--)
+			{
+				for (int x = 0; x < m_nsegments; x++)
+				{
+					storeByte(y, x, loadByte(y - 1, x));
+				}
+			}
+			for (int x = 0; x < m_nsegments; x++)
+			{
+				storeByte(0, x, 0);		// Clear first row
+			}
 			break;
 
 		case ScrollDirection::Right:
@@ -190,9 +672,9 @@ void LEDMatrixDriver::scroll( ScrollDirection direction )
 				uint8_t carry = 0x00;
 				for (int x = 0; x < m_nsegments; x++)
 				{
-					uint8_t& v = m_frameBuffer[y*m_nsegments+x];
+					uint8_t v = loadByte(y, x);
 					uint8_t newCarry = v & 1;
-					v = (carry << 7) | (v >> 1);
+					storeByte(y, x, (carry << 7) | (v >> 1));
 					carry = newCarry;
 				}
 			}
@@ -206,9 +688,9 @@ void LEDMatrixDriver::scroll( ScrollDirection direction )
 				uint8_t carry = 0x00;
 				for (int x = m_nsegments-1; x >= 0; x--)
 				{
-					uint8_t& v = m_frameBuffer[y*m_nsegments+x];
+					uint8_t v = loadByte(y, x);
 					uint8_t newCarry = v & 0x80;
-					v = (carry >> 7) | (v << 1);
+					storeByte(y, x, (carry >> 7) | (v << 1));
 					carry = newCarry;
 				}
 			}
@@ -216,38 +698,91 @@ void LEDMatrixDriver::scroll( ScrollDirection direction )
 	}
 }
 
-void LEDMatrixDriver::drawSprite( uint8_t* sprite, int x, int y, int width, int height )
+void LEDMatrixDriver::blitByte(uint8_t y, uint8_t column, uint8_t value, uint8_t mask)
 {
-  // The mask is used to get the column bit from the sprite row
-  uint8_t mask = 0x80;
-  for( int iy = 0; iy < height; iy++ )
-  {
-    for( int ix = 0; ix < width; ix++ )
+	if (m_reverseBits) {
+		value = reverseByte(value);
+		mask = reverseByte(mask);
+	}
+
+	uint8_t row = bufferRow(y);
+	uint8_t col = bufferColumn(column);
+	uint8_t current = m_frameBuffer[row*m_nsegments + col];
+	writeByte(row, col, (current & ~mask) | (value & mask));
+}
+
+
+void LEDMatrixDriver::drawSprite( const uint8_t* sprite, int x, int y, int width, int height )
+{
+  if (width > 8) {
+    // Rows are single bytes; pixels beyond the 8th column are cleared as before
+    for( int iy = 0; iy < height; iy++ )
     {
-      setPixel(x + ix, y + iy, (bool)(sprite[iy] & mask));
+      for( int ix = 8; ix < width; ix++ )
+      {
+        setPixel(x + ix, y + iy, false);
+      }
+    }
+    width = 8;
+  }
 
-      // Shift the mask by one pixel to the right
-      mask = mask >> 1;
+  // Clip the sprite once
+  int width_px = 8*m_nsegments;
+  if (width <= 0 || x >= width_px || x + width <= 0)
+    return;
+
+  int fromY = y < 0 ? 0 : y;
+  int toY = y + height > 8 ? 8 : y + height;
+
+  // The sprite row covers the columns B and B+1 of the framebuffer
+  int B = x >> 3;		// Rounds down for negative x as well
+  uint8_t shift = x & 7;
+  uint8_t rowMask = 0xFF << (8 - width);
+  uint8_t leftMask = rowMask >> shift;
+  uint8_t rightMask = rowMask << (8 - shift);
+  bool leftVisible = (B >= 0) && leftMask;
+  bool rightVisible = (B + 1 < m_nsegments) && rightMask;
+
+  for( int iy = fromY; iy < toY; iy++ )
+  {
+    uint8_t bits = sprite[iy - y];
+    if (shift == 0) {
+      // Aligned: a plain byte store
+      if (rowMask == 0xFF)
+        storeByte(iy, B, bits);
+      else
+        blitByte(iy, B, bits, rowMask);
+      continue;
     }
-    // Reset column mask
-    mask = 0x80;
+
+    if (leftVisible)
+      blitByte(iy, B, bits >> shift, leftMask);
+    if (rightVisible)
+      blitByte(iy, B + 1, bits << (8 - shift), rightMask);
   }
 }
 
 void LEDMatrixDriver::drawString( const char* text, int len, int x, int y )
 {
-  for( int idx = 0; idx < len; idx ++ )
-  {
-    int c = text[idx] - 32;
+  // Skip the chars which are left of the visible area at once
+  int first = x < -8 ? (-x - 1) / 8 : 0;
 
+  for( int idx = first; idx < len; idx ++ )
+  {
     // Stop if char is outside visible area
     if( x + idx * 8  > m_nsegments*8 )
       return;
 
     // Only draw if char is visible
     if( 8 + x + idx * 8 > 0 ) {
-			drawSprite( font[c], x + idx * 8, y, 8, 8 );
+			drawSprite( glyph((uint8_t)text[idx]), x + idx * 8, y, 8, 8 );
     }
 
   }
 }
+
+
+const uint8_t* LEDMatrixDriver::glyph( uint16_t codepoint )
+{
+	return glyphCache.get(codepoint);
+}
@@ -2,22 +2,19 @@
 #define ESP_LED_MATRIX_DRIVER_H
 
 #include <SPI.h>
+#include <Ticker.h>
 #include <cstring>
+#include "LEDMatrixBus.h"
 
-class LEDMatrixDriver
+class LEDMatrixDriver : public LEDMatrixBus
 {
-	// Commands from the datasheet
-	const static uint16_t CMD_ENABLE = 0x0C00;
-	const static uint16_t CMD_INTENSITY =	0x0A00;
-	const static uint16_t CMD_TEST = 0x0F00;
-	const static uint16_t CMD_SCAN_LIMIT = 0x0B00;
-	const static uint16_t CMD_DECODE = 0x0900;
-
-
 	public:
 		const static uint8_t INVERT_SEGMENT_X = 1;
 		const static uint8_t INVERT_DISPLAY_X = 2;
 		const static uint8_t INVERT_Y = 4;
+		// Store the framebuffer in MAX7219 transmit order.
+		// Orientation is applied once when pixels are written instead of on every frame.
+		const static uint8_t WIRE_ORDER = 8;
 
 		// Constructor:
 		// N - Number of segments
@@ -32,11 +29,7 @@ class LEDMatrixDriver
 		LEDMatrixDriver(LEDMatrixDriver&& other) = delete;
 		LEDMatrixDriver& operator=(const LEDMatrixDriver& other) = delete;
 
-		// All these commands work on ALL segments
-		void setEnabled(bool enabled);
-
-		// Set brightness: 0 - 15
-		void setBrightness(uint8_t level);
+		// setEnabled(), setBrightness() and setRegisterResync() come from LEDMatrixBus
 
 		void setPixel(int16_t x, int16_t y, bool enabled);
 		bool getPixel(int16_t x, int16_t y) const;
@@ -44,23 +37,79 @@ class LEDMatrixDriver
 		/* Sets pixels in the column acording to value (LSB => y=0) */
 		void setColumn(int16_t x, uint8_t value);
 
-		uint8_t getSegments() const { return m_nsegments; }
+		// Returns the raw framebuffer. With WIRE_ORDER it is in transmit order.
 		uint8_t* getFrameBuffer() const { return m_frameBuffer; }
 
-		// Writes the data to the display
+		// Copy a logical row of N bytes (MSB of the first byte is the leftmost pixel) in any layout.
+		// writeRow() marks only the bytes which differ as changed.
+		void readRow(uint8_t y, uint8_t* bytes) const;
+		void writeRow(uint8_t y, const uint8_t* bytes);
+
+		// Writes count bytes of a logical row starting at the 8-pixel column
+		void writeRow(uint8_t y, const uint8_t* bytes, uint8_t column, uint8_t count);
+
+		// Writes the changed rows to the display in one SPI transaction.
+		// Segments which have not changed in a row are skipped with no-op words.
 		void display();
 
-		// Writes a single row to the display
+		// Duration of the last frame push which has sent data, in microseconds
+		uint32_t displayMicros() const { return m_displayMicros; }
+
+		// Starts pushing a front buffer to the display from a timer every intervalMillis.
+		// Rendering keeps going to the framebuffer, and display() then only commits
+		// the finished frame to the front buffer, so the timer never sends a half-drawn frame.
+		void startRefresh(uint16_t intervalMillis);
+		void stopRefresh();
+		bool refreshActive() const { return m_refreshActive; }
+
+		// Copies the changed segments of the framebuffer to the front buffer
+		void commit();
+
+		// Like display(), but with the refresh active the frame is sent at once instead of by the timer
+		void flush();
+
+		// 2-bit greyscale by temporal dithering in count 8-pixel columns from column.
+		// high and low are bitplanes of 8 logical rows of count bytes. A timer sends the bright
+		// plane for two sub-frames and the dim one for the third, so a pixel is on for
+		// (2*high + low)/3 of the time. Only rows where the planes differ are sent, with
+		// no-op words for the other segments. The bright plane goes to the framebuffer.
+		void setGreyscale(uint8_t column, uint8_t count, const uint8_t* high, const uint8_t* low);
+
+		// Stops dithering, the region shows the framebuffer again
+		void clearGreyscale();
+
+		// Milliseconds per sub-frame, 0 - the bright plane only
+		void setDitherPeriod(uint16_t periodMillis) { m_ditherPeriod = periodMillis; }
+
+		// Microseconds spent in SPI transfers of frames and in the timer callbacks since start.
+		// The counters wrap around, differences of two readings are valid.
+		uint32_t spiMicros() const { return m_spiMicros; }
+		uint32_t timerMicros() const { return m_timerMicros; }
+
+		// Writes a single row of the framebuffer to the display (all segments)
 		void displayRow(uint8_t row);
 
 		// Clear the framebuffer
-		void clear() { memset(m_frameBuffer, 0, 8*m_nsegments); }
+		void clear();
+
+		// Marks the whole framebuffer as changed, so the next display() pushes everything.
+		// It must be called after writing to the buffer returned by getFrameBuffer().
+		void invalidate();
 
-		// Draws a sprite at x,y coordinates with width,height pixels
-		void drawSprite( uint8_t* sprite, int x, int y, int width, int height );
+		// Returns true if there are changes which have not been sent to the display yet
+		bool isDirty() const { return m_dirtyRows != 0; }
+
+		// Draws a sprite at x,y coordinates with width,height pixels.
+		// Every sprite row is one byte (MSB is the leftmost pixel) and it is written
+		// with one or two masked byte stores.
+		void drawSprite( const uint8_t* sprite, int x, int y, int width, int height );
 
 		void drawString( const char* text, int len, int x, int y );
 
+		// Returns the 8x8 bitmap of a code point (one byte per row).
+		// The font is in flash, the pointer is valid until the next call.
+		static const uint8_t* glyph( uint16_t codepoint );
+
 		enum class ScrollDirection
 		{
 			Up = 0,
@@ -69,8 +118,21 @@ class LEDMatrixDriver
 			Right
 		};
 
-		// Scrolls the framebuffer 1 pixel in the given direction
-		void scroll( ScrollDirection direction );
+		// Scrolls the framebuffer by the given number of pixels in the given direction
+		void scroll( ScrollDirection direction, uint8_t pixels = 1 );
+
+		// Scrolls the framebuffer 1 pixel with a byte-wise carry loop.
+		// It is the reference implementation for the word-wide kernels in scroll().
+		void scrollReference( ScrollDirection direction );
+
+		// Shift a row of n bytes (MSB of the first byte is the leftmost pixel) by the given
+		// number of pixels. The row is processed in 32-bit words, vacated pixels are cleared.
+		static void shiftRowLeft( uint8_t* row, uint8_t n, uint16_t pixels ) { shiftRowLeft(row, row, n, pixels); }
+		static void shiftRowRight( uint8_t* row, uint8_t n, uint16_t pixels ) { shiftRowRight(row, row, n, pixels); }
+
+		// The same from the row src into dst, src may be dst
+		static void shiftRowLeft( const uint8_t* src, uint8_t* dst, uint8_t n, uint16_t pixels );
+		static void shiftRowRight( const uint8_t* src, uint8_t* dst, uint8_t n, uint16_t pixels );
 
 		// A helper function to reverse bits in a byte
 		static uint8_t reverseByte(uint8_t b);
@@ -79,14 +141,116 @@ class LEDMatrixDriver
 		// Returns a pointer to the byte which contains the specified pixel
 		uint8_t* getPixelsBytePtr(int16_t x, int16_t y) const;
 
-		// Transfers a 16-bit word by SPI
-		void tranferCommand(uint16_t command);
+		// Encodes the command words of a row of the buffer into the transmit buffer.
+		// If dirtySegments is given, segments which have not changed get a no-op word.
+		void encodeRow(const uint8_t* buffer, const uint8_t* dirtySegments, uint8_t row);
+
+		// Sends the dirty rows of the buffer in one SPI transaction and clears their marks.
+		// Returns false if there was nothing to send.
+		bool pushFrame(const uint8_t* buffer, uint8_t* dirtySegments, uint8_t& dirtyRows);
+
+		// Sends a row of the buffer to the display and clears its segment marks.
+		// The caller owns the SPI transaction.
+		void sendRow(const uint8_t* buffer, uint8_t* dirtySegments, uint8_t row);
+
+		// Pushes the front buffer, it is called by the refresh timer
+		static void refreshCallback(LEDMatrixDriver* driver);
+
+		// Makes display() commit to a front buffer. Whoever started the refresh pushes it.
+		void attachFrontBuffer();
+
+		// Sends the sub-frame of the greyscale region, it is called by the dither timer
+		static void ditherCallback(LEDMatrixDriver* driver);
+
+		// Sends a logical row of the greyscale region, other segments get no-op words.
+		// The caller owns the SPI transaction.
+		void sendGreyscaleRow(uint8_t y, const uint8_t* bytes);
+
+		// Marks the greyscale rows of the region as changed, so the framebuffer is sent again
+		void markGreyscaleDirty();
+
+		// The canvas pushes several drivers in one interleaved transaction
+		friend class LEDMatrixCanvas;
+
+		bool m_ownsFrameBuffer = false;
+
+		// A logical row used by the scroll kernels
+		uint8_t* m_rowBuffer = nullptr;
+
+		// Timer refresh. Ticker callbacks run in the system context between loop() iterations
+		// and yields, so they never interrupt rendering or commit().
+		Ticker m_refreshTicker;
+		bool m_refreshActive = false;
+		uint8_t* m_frontBuffer = nullptr;
+		uint8_t* m_frontDirtySegments = nullptr;
+		uint8_t m_frontDirtyRows = 0;
+
+		// Greyscale region: both bitplanes, rows where they differ and the sub-frame
+		Ticker m_ditherTicker;
+		uint16_t m_ditherPeriod = 3;
+		uint8_t* m_greyPlanes = nullptr;
+		uint8_t m_greyColumn = 0;
+		uint8_t m_greyCount = 0;
+		uint8_t m_greyRows = 0;
+		uint8_t m_greyPhase = 0;
+
+	protected:
+		// Map a logical pixel row / 8-pixel column to the position in the framebuffer
+		uint8_t bufferRow(uint8_t y) const { return m_invertRows ? 7 - y : y; }
+		uint8_t bufferColumn(uint8_t column) const { return m_invertColumns ? m_nsegments - 1 - column : column; }
+
+		// Returns a mask of the pixel x in its framebuffer byte
+		uint8_t pixelMask(int16_t x) const { return m_reverseBits ? (1 << (x & 7)) : (0x80 >> (x & 7)); }
+
+		// Read and write 8 pixels of a logical row (MSB is the leftmost pixel) in any layout
+		uint8_t loadByte(uint8_t y, uint8_t column) const;
+		void storeByte(uint8_t y, uint8_t column, uint8_t value);
+
+		// Writes a byte to the framebuffer and marks its segment as changed if the value differs
+		void writeByte(uint8_t row, uint8_t column, uint8_t value);
+
+		// Writes a framebuffer row of N bytes, the segments which differ are marked as changed
+		void writeBufferRow(uint8_t row, const uint8_t* bytes);
+
+		// Replaces the pixels selected by mask in 8 pixels of a logical row
+		void blitByte(uint8_t y, uint8_t column, uint8_t value, uint8_t mask);
+
+		// Marks a segment in a row as changed
+		void markDirty(uint8_t row, uint8_t segment) {
+			m_dirtySegments[row*m_dirtyStride + (segment >> 3)] |= (1 << (segment & 7));
+			m_dirtyRows |= (1 << row);
+		}
+
+		bool isSegmentDirty(uint8_t row, uint8_t segment) const {
+			return isSegmentDirty(m_dirtySegments, row, segment);
+		}
+
+		bool isSegmentDirty(const uint8_t* dirtySegments, uint8_t row, uint8_t segment) const {
+			return dirtySegments[row*m_dirtyStride + (segment >> 3)] & (1 << (segment & 7));
+		}
+
+		// Marks a row as sent
+		void clearDirtyRow(uint8_t row) {
+			memset(m_dirtySegments + row*m_dirtyStride, 0, m_dirtyStride);
+			m_dirtyRows &= ~(1 << row);
+		}
 
-		const uint8_t m_nsegments;
-		SPISettings m_spiSettings;
 		uint8_t m_flags = 0;
 		uint8_t* m_frameBuffer = nullptr;
-		uint8_t m_ssPin;
+
+		uint32_t m_displayMicros = 0;
+		uint32_t m_spiMicros = 0;
+		uint32_t m_timerMicros = 0;
+
+		// Orientation which is applied at write time (WIRE_ORDER)
+		bool m_invertRows = false;
+		bool m_invertColumns = false;
+		bool m_reverseBits = false;
+
+		// Dirty tracking: one bit per row and one bit per segment in every row
+		uint8_t m_dirtyRows = 0;
+		uint8_t m_dirtyStride = 0;
+		uint8_t* m_dirtySegments = nullptr;
 };
 
 #endif /* LEDMATRIXDRIVER_H_ */
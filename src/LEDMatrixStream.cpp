@@ -0,0 +1,215 @@
+#include "LEDMatrixStream.h"
+#include <Arduino.h>
+#include "LEDMatrixDriver.h"
+
+LEDMatrixStream::LEDMatrixStream(uint8_t nsegments, uint8_t ssPin, uint8_t flags) :
+	LEDMatrixBus(nsegments, ssPin),
+	m_flags(flags)
+{
+	m_row = new uint8_t[m_nsegments];
+}
+
+LEDMatrixStream::~LEDMatrixStream()
+{
+	if (m_row) {
+		delete[] m_row;
+	}
+}
+
+
+uint8_t LEDMatrixStream::addText(int16_t x, int16_t width, FontStyle font, unsigned long pixelPeriod)
+{
+	Item item = {};
+	item.kind = ItemKind::Text;
+	item.font = font;
+	item.x = x;
+	item.width = width;
+	item.pixelPeriod = pixelPeriod;
+	m_items.push_back(item);
+	return m_items.size() - 1;
+}
+
+
+uint8_t LEDMatrixStream::addIcon(int16_t x, const uint8_t* icon)
+{
+	Item item = {};
+	item.kind = ItemKind::Icon;
+	item.x = x;
+	item.width = 8;
+	if (icon) {
+		memcpy(item.icon, icon, 8);
+	}
+	m_items.push_back(item);
+	return m_items.size() - 1;
+}
+
+
+void LEDMatrixStream::setText(uint8_t index, const char16_t* text, int len, unsigned long now)
+{
+	Item& item = m_items[index];
+	item.text.assign(text, len);
+
+	// Advance widths are kept with the text, so rows do not measure glyphs again
+	item.advances.resize(len);
+	item.textWidth = 0;
+	for (int idx = 0; idx < len; idx++) {
+		item.advances[idx] = Typeface::advance(item.font, text[idx]);
+		item.textWidth += item.advances[idx];
+	}
+	item.start = now;
+}
+
+
+void LEDMatrixStream::setIcon(uint8_t index, const uint8_t* icon)
+{
+	memcpy(m_items[index].icon, icon, 8);
+}
+
+
+void LEDMatrixStream::clearList()
+{
+	m_items.clear();
+}
+
+
+void LEDMatrixStream::orByte(int16_t x, uint8_t bits, int16_t clipFrom, int16_t clipTo)
+{
+	if (x < clipFrom) {
+		if (clipFrom - x >= 8)
+			return;
+		bits &= 0xFF >> (clipFrom - x);
+	}
+	if (x + 8 > clipTo) {
+		if (x + 8 - clipTo >= 8)
+			return;
+		bits &= 0xFF << (x + 8 - clipTo);
+	}
+	if (bits == 0)
+		return;
+
+	int16_t B = x >> 3;		// Rounds down for negative x as well
+	uint8_t shift = x & 7;
+	if (B >= 0 && B < m_nsegments)
+		m_row[B] |= bits >> shift;
+	if (shift && B + 1 >= 0 && B + 1 < m_nsegments)
+		m_row[B + 1] |= bits << (8 - shift);
+}
+
+
+void LEDMatrixStream::collectText(const Item& item)
+{
+	int16_t clipFrom = item.x < 0 ? 0 : item.x;
+	int16_t clipTo = item.x + item.width;
+
+	// A scrolling text is followed by an empty view and wraps around
+	bool scrolling = item.pixelPeriod && (item.textWidth > item.width);
+	int16_t period = item.textWidth + item.width;
+	int16_t origin = scrolling ? item.x - item.offset : item.x + (item.width - item.textWidth) / 2;
+	uint8_t copies = scrolling ? 2 : 1;
+
+	Sprite sprite;
+	sprite.clipFrom = clipFrom;
+	sprite.clipTo = clipTo;
+	for (uint8_t copy = 0; copy < copies; copy++, origin += period)
+	{
+		int16_t gx = origin;
+		for (size_t idx = 0; idx < item.text.length(); idx++)
+		{
+			uint8_t advance = item.advances[idx];
+			if (gx >= clipTo)
+				break;
+			if (gx + advance > clipFrom) {
+				sprite.x = gx;
+				Typeface::glyph(item.font, item.text[idx], sprite.rows);
+				if (advance < 8) {
+					for (uint8_t y = 0; y < 8; y++) {
+						sprite.rows[y] &= 0xFF << (8 - advance);
+					}
+				}
+				m_sprites.push_back(sprite);
+			}
+			gx += advance;
+		}
+	}
+}
+
+
+void LEDMatrixStream::encodeRow(uint8_t y)
+{
+	uint8_t address = (m_flags & LEDMatrixDriver::INVERT_Y ? 7 - y : y) + 1;
+	bool displayInverted = m_flags & LEDMatrixDriver::INVERT_DISPLAY_X;
+	bool segmentInverted = m_flags & LEDMatrixDriver::INVERT_SEGMENT_X;
+
+	uint8_t* tx = m_txBuffer;
+	for (uint8_t i = 0; i < m_nsegments; i++)
+	{
+		uint8_t data = m_row[displayInverted ? m_nsegments - 1 - i : i];
+		*tx++ = address;
+		*tx++ = segmentInverted ? LEDMatrixDriver::reverseByte(data) : data;
+	}
+}
+
+
+void LEDMatrixStream::display(unsigned long now)
+{
+	uint32_t start = micros();
+	bool sent = false;
+
+	if (++m_framesSinceResend >= RESEND_FRAMES) {
+		m_framesSinceResend = 0;
+		m_rowsValid = 0;
+	}
+
+	// Scroll positions are fixed for the whole frame, so rows do not tear,
+	// and the glyphs in view are looked up once for all rows
+	m_sprites.clear();
+	for (Item& item : m_items) {
+		if (item.kind == ItemKind::Icon) {
+			Sprite sprite;
+			sprite.x = item.x;
+			sprite.clipFrom = item.x;
+			sprite.clipTo = item.x + 8;
+			memcpy(sprite.rows, item.icon, 8);
+			m_sprites.push_back(sprite);
+			continue;
+		}
+
+		if (item.pixelPeriod && (item.textWidth > item.width)) {
+			item.offset = ((now - item.start) / item.pixelPeriod) % (item.textWidth + item.width);
+		}
+		collectText(item);
+	}
+
+	SPI.beginTransaction(m_spiSettings);
+	for (uint8_t y = 0; y < 8; y++)
+	{
+		memset(m_row, 0, m_nsegments);
+		for (const Sprite& sprite : m_sprites) {
+			orByte(sprite.x, sprite.rows[y], sprite.clipFrom, sprite.clipTo);
+		}
+
+		// FNV-1a of the row
+		uint32_t hash = 2166136261u;
+		for (uint8_t i = 0; i < m_nsegments; i++) {
+			hash = (hash ^ m_row[i]) * 16777619u;
+		}
+		if ((m_rowsValid & (1 << y)) && (m_rowHash[y] == hash))
+			continue;
+		m_rowHash[y] = hash;
+		m_rowsValid |= (1 << y);
+
+		encodeRow(y);
+		select();
+		SPI.writeBytes(m_txBuffer, 2*m_nsegments);
+		deselect();
+		sent = true;
+	}
+	SPI.endTransaction();
+
+	if (sent) {
+		resyncStep();
+		m_displayMicros = micros() - start;
+		m_spiMicros += m_displayMicros;
+	}
+}
+
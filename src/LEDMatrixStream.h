@@ -0,0 +1,127 @@
+#ifndef ESP_LED_MATRIX_STREAM_H
+#define ESP_LED_MATRIX_STREAM_H
+
+#include <string>
+#include <vector>
+#include "LEDMatrixBus.h"
+#include "Typeface.h"
+
+/*
+ * A MAX7219 chain without a framebuffer.
+ *
+ * The content is a display list of text runs and icons. Every frame the glyphs
+ * which are in view are looked up once, then each row is rasterised from them into
+ * a row buffer, encoded to command words and sent before the next row is generated,
+ * so RAM is one row plus the display list and the visible glyphs.
+ * A clock is a text run which is updated once a second.
+ *
+ * A row which is the same as the last time it was sent is skipped. Rows are compared by
+ * a checksum, so every RESEND_FRAMES frames all rows are sent: a row which a collision
+ * of checksums has kept off the display does not stay there.
+ * Control registers are shadowed and resynced by LEDMatrixBus like in LEDMatrixDriver.
+ */
+class LEDMatrixStream : public LEDMatrixBus
+{
+	public:
+		// All rows are sent at least every RESEND_FRAMES calls of display()
+		static const uint8_t RESEND_FRAMES = 64;
+
+		// N - Number of segments
+		// ssPin - Select slave pin
+		// flags - orientation, LEDMatrixDriver::INVERT_* (WIRE_ORDER has no meaning here)
+		LEDMatrixStream(uint8_t N, uint8_t ssPin, uint8_t flags = 0);
+		~LEDMatrixStream();
+
+		LEDMatrixStream(const LEDMatrixStream& other) = delete;
+		LEDMatrixStream& operator=(const LEDMatrixStream& other) = delete;
+
+		// Adds a text run in the columns [x, x + width). A text which does not fit scrolls
+		// by a pixel every pixelPeriod milliseconds (0 - never), otherwise it is centered.
+		// Returns the index of the item.
+		uint8_t addText(int16_t x, int16_t width, FontStyle font, unsigned long pixelPeriod = 0);
+
+		// Adds an 8x8 icon at x. Returns the index of the item.
+		uint8_t addIcon(int16_t x, const uint8_t* icon = nullptr);
+
+		// Replace the content of an item. A new text starts scrolling from the beginning.
+		void setText(uint8_t item, const char16_t* text, int len, unsigned long now);
+		void setIcon(uint8_t item, const uint8_t* icon);
+
+		// Removes all items
+		void clearList();
+
+		// Generates and sends the rows of the frame for the given time
+		void display(unsigned long now);
+
+		// Makes the next display() send all rows
+		void invalidate() { m_rowsValid = 0; }
+
+		// Duration of the last frame which has sent data, in microseconds
+		uint32_t displayMicros() const { return m_displayMicros; }
+
+		// Microseconds spent in display() since start, rows are generated while they are sent.
+		// The counter wraps around, differences of two readings are valid.
+		uint32_t spiMicros() const { return m_spiMicros; }
+
+	private:
+		enum class ItemKind : uint8_t
+		{
+			Text = 0,
+			Icon
+		};
+
+		struct Item
+		{
+			ItemKind kind;
+			FontStyle font;
+			int16_t x;
+			int16_t width;
+			unsigned long pixelPeriod;
+
+			// Text run
+			std::u16string text;
+			std::vector<uint8_t> advances;
+			int16_t textWidth;
+			unsigned long start;
+			int16_t offset;		// pixel of the text at x, it is fixed for a frame
+
+			uint8_t icon[8];
+		};
+
+		// A glyph or an icon in view: 8 rows of 8 pixels at x, clipped to its item
+		struct Sprite
+		{
+			int16_t x;
+			int16_t clipFrom;
+			int16_t clipTo;
+			uint8_t rows[8];
+		};
+
+		// ORs 8 pixels (MSB is the leftmost) at x into the row, clipped to [clipFrom, clipTo)
+		void orByte(int16_t x, uint8_t bits, int16_t clipFrom, int16_t clipTo);
+
+		// Appends the glyphs of the text which are in view to m_sprites
+		void collectText(const Item& item);
+
+		// Encodes m_row into the transmit buffer for the row address of y
+		void encodeRow(uint8_t y);
+
+		uint8_t m_flags;
+
+		std::vector<Item> m_items;
+
+		// The glyphs and icons of the current frame, the capacity is kept between frames
+		std::vector<Sprite> m_sprites;
+
+		uint8_t* m_row = nullptr;			// a logical row, MSB of the first byte is the leftmost pixel
+
+		// Checksums of the rows on the display
+		uint32_t m_rowHash[8] = {};
+		uint8_t m_rowsValid = 0;
+		uint8_t m_framesSinceResend = 0;
+
+		uint32_t m_displayMicros = 0;
+		uint32_t m_spiMicros = 0;
+};
+
+#endif /* ESP_LED_MATRIX_STREAM_H */
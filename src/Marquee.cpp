@@ -0,0 +1,110 @@
+#include "Marquee.h"
+#include "LEDMatrixDriver.h"
+
+Marquee::Marquee()
+{
+}
+
+
+Marquee::~Marquee()
+{
+}
+
+
+void Marquee::setText( const char16_t *text, int len, FontStyle font, int viewX, int viewWidth, unsigned long now )
+{
+  int textWidth = Typeface::textWidth(font, text, len);
+  int widest = MAX_PERIOD - viewWidth;
+  if (textWidth > widest) {
+    textWidth = widest;
+  }
+
+  m_viewX = viewX;
+  m_viewWidth = viewWidth;
+  m_scrolling = textWidth > viewWidth;
+  m_start = now;
+  m_lastOffset = -1;
+
+  // A scrolling text is followed by an empty view, otherwise the text is centered in the view
+  int textX = m_scrolling ? 0 : (viewWidth - textWidth) / 2;
+  m_period = m_scrolling ? textWidth + viewWidth : viewWidth;
+  m_stride = (m_period + 7) >> 3;
+  memset(m_strip, 0, 8 * m_stride);
+
+  uint8_t rows[8];
+  int x = textX;
+  int textEnd = textX + textWidth;
+  for (int idx = 0; (idx < len) && (x < textEnd); idx++) {
+    Typeface::glyph(font, text[idx], rows);
+    for (uint8_t y = 0; y < 8; y++) {
+      uint8_t bits = rows[y];
+      for (uint8_t ix = 0; (ix < 8) && (x + ix < textEnd); ix++) {
+        if (bits & (0x80 >> ix)) {
+          setStripPixel(y, x + ix);
+        }
+      }
+    }
+    x += Typeface::advance(font, text[idx]);
+  }
+}
+
+
+void Marquee::clear()
+{
+  m_period = 0;
+  m_scrolling = false;
+  m_lastOffset = -1;
+}
+
+
+void Marquee::setStripPixel( uint8_t y, uint16_t position )
+{
+  m_strip[y * m_stride + (position >> 3)] |= 0x80 >> (position & 7);
+}
+
+
+uint8_t Marquee::stripByte( uint8_t y, uint16_t position ) const
+{
+  const uint8_t *row = m_strip + y * m_stride;
+
+  if (position + 8 <= m_period) {
+    uint16_t B = position >> 3;
+    uint8_t shift = position & 7;
+    return shift ? (row[B] << shift) | (row[B + 1] >> (8 - shift)) : row[B];
+  }
+
+  // The window crosses the end of the strip
+  uint8_t value = 0;
+  for (uint8_t ix = 0; ix < 8; ix++) {
+    uint16_t p = (position + ix) % m_period;
+    if (row[p >> 3] & (0x80 >> (p & 7))) {
+      value |= 0x80 >> ix;
+    }
+  }
+  return value;
+}
+
+
+void Marquee::render( LEDMatrixDriver *driver, unsigned long now )
+{
+  if (m_period == 0) {
+    return;
+  }
+
+  long offset = m_scrolling ? ((now - m_start) / PIXEL_PERIOD) % m_period : 0;
+  if (offset == m_lastOffset) {
+    return;
+  }
+  m_lastOffset = offset;
+
+  // Copy the window to the view 8 columns at a time
+  uint8_t column[8];
+  for (int x = 0; x < m_viewWidth; x += 8) {
+    uint16_t position = (offset + x) % m_period;
+    for (uint8_t y = 0; y < 8; y++) {
+      column[y] = stripByte(y, position);
+    }
+    int width = m_viewWidth - x < 8 ? m_viewWidth - x : 8;
+    driver->drawSprite(column, m_viewX + x, 0, width, 8);
+  }
+}
@@ -0,0 +1,66 @@
+#ifndef ESP_INFORMER_MARQUEE_H
+#define ESP_INFORMER_MARQUEE_H
+
+#include <Arduino.h>
+#include "Config.h"
+#include "Typeface.h"
+
+class LEDMatrixDriver;
+
+/*
+ * Text which is laid out and rasterised once into a bitmap strip.
+ * Every frame only copies a window of the strip into the view.
+ * A text which does not fit the view scrolls continuously: the strip
+ * is the text followed by a gap of the view width and wraps around.
+ * The strip is a fixed buffer for the longest message, a new text does not allocate.
+ */
+class Marquee
+{
+public:
+  Marquee();
+  ~Marquee();
+
+  /* Milliseconds per pixel of scrolling */
+  static const unsigned long PIXEL_PERIOD = 50;
+
+  /* The widest strip: a message in cells of up to 9 pixels and the gap. Pixels of a wider text are cut */
+  static const uint16_t MAX_PERIOD = 9 * MESSAGE_TEXT_CAPACITY + LEDMATRIX_WIDTH;
+
+  /*
+   * Lays out the text (code points) in the font for a view at viewX with viewWidth pixels.
+   * A short text is centered, a long one starts at the left side of the view.
+   */
+  void setText( const char16_t *text, int len, FontStyle font, int viewX, int viewWidth, unsigned long now );
+
+  /* Forgets the text */
+  void clear();
+
+  /* Returns true if the text does not fit the view */
+  bool scrolling() const { return m_scrolling; }
+
+  /* Draws the window for the given time. Nothing is drawn if the window has not moved */
+  void render( LEDMatrixDriver *driver, unsigned long now );
+
+  /* Makes the next render() draw the window again, e.g. after the display was cleared */
+  void invalidate() { m_lastOffset = -1; }
+
+  /* Scrolls from the beginning of the text again */
+  void restart( unsigned long now ) { m_start = now; m_lastOffset = -1; }
+
+private:
+  /* Returns 8 pixels of a strip row starting at position, wrapping at the end of the strip */
+  uint8_t stripByte( uint8_t y, uint16_t position ) const;
+  void setStripPixel( uint8_t y, uint16_t position );
+
+  uint8_t m_strip[8 * ((MAX_PERIOD + 7) >> 3)];
+  uint16_t m_stride = 0;    // bytes per strip row
+  uint16_t m_period = 0;    // strip width in pixels
+
+  int m_viewX = 0;
+  int m_viewWidth = 0;
+  bool m_scrolling = false;
+  unsigned long m_start = 0;
+  long m_lastOffset = -1;
+};
+
+#endif //ESP_INFORMER_MARQUEE_H
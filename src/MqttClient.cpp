@@ -1,5 +1,6 @@
 #include "MqttClient.h"
 #include "LEDMatrixDevice.h"
+#include "SoftClock.h"
 
 #include <string>
 
@@ -67,6 +68,12 @@ void DeviceMqttClient::onMqttDisconnect(AsyncMqttClientDisconnectReason reason)
 
 void DeviceMqttClient::onMqttMessage(char* topic, char* payload, AsyncMqttClientMessageProperties properties, size_t len, size_t index, size_t total)
 {
+  /* Raw frame: the payload goes to the framebuffer as it is, without logging and parsing */
+  if (strcmp(topic, "informer/set/frame") == 0) {
+    m_device->writeFrame(reinterpret_cast<const uint8_t*>(payload), index, len, total);
+    return;
+  }
+
   Serial.println();
   Serial.println("MQTT: Message received.");
   Serial.printf("  topic: %s\n", topic);
@@ -87,18 +94,11 @@ void DeviceMqttClient::onMqttMessage(char* topic, char* payload, AsyncMqttClient
 
     /* Notification */
     if (std::string(topic) == "informer/set/notification") {
-      std::vector<byte> icon;
-      if (json.containsKey("icon")) {
-        JsonArray &iconArray = json["icon"];
-        if (iconArray.size() % 8 == 0) {
-          for (auto &byteValue : iconArray) {
-            icon.push_back(byteValue.as<byte>());
-          }
-        }
-      }
-
-      std::string textString = "";
-      if (json.containsKey("text")) {
+      AnimatedIcon icon = parseIcon(json);
+
+      // The text stays in the JSON buffer, the device decodes it into its record
+      const char *textString = "";
+      if (json["text"].is<const char*>()) {
         textString = json["text"].as<const char*>();
       }
 
@@ -107,7 +107,27 @@ void DeviceMqttClient::onMqttMessage(char* topic, char* payload, AsyncMqttClient
         timeout = json["timeout"].as<int>();
       }
 
-      m_device->setNotification(icon, textString, timeout);
+      FontStyle font = FontStyle::Fixed;
+      if (json.containsKey("font")) {
+        font = Typeface::fromName( json["font"].as<const char*>() );
+      }
+
+      // Delivery: priority, preemption of the notification on the display, time to live and a key to replace
+      NotificationOptions options;
+      if (json.containsKey("priority")) {
+        options.priority = json["priority"].as<uint8_t>();
+      }
+      if (json.containsKey("preempt")) {
+        options.preempt = json["preempt"].as<bool>();
+      }
+      if (json.containsKey("ttl")) {
+        options.ttl = json["ttl"].as<unsigned long>();
+      }
+      if (json["key"].is<const char*>()) {
+        options.key = json["key"].as<const char*>();
+      }
+
+      m_device->setNotification(icon, textString, timeout, font, options);
     }
 
     /* Settings */
@@ -124,6 +144,26 @@ void DeviceMqttClient::onMqttMessage(char* topic, char* payload, AsyncMqttClient
       if (json.containsKey("secondsVisible")) {
         m_device->setSecondsVisible( json["secondsVisible"].as<bool>() );
       }
+
+      if (json.containsKey("clockFont")) {
+        m_device->setClockFont( Typeface::fromName( json["clockFont"].as<const char*>() ) );
+      }
+
+      if (json.containsKey("clockZone")) {
+        m_device->setClockZoneVisible( json["clockZone"].as<bool>() );
+      }
+
+      if (json.containsKey("transition")) {
+        m_device->setTransitionEffect( Transition::effectFromName( json["transition"].as<const char*>() ) );
+      }
+
+      if (json.containsKey("transitionDuration")) {
+        m_device->setTransitionDuration( json["transitionDuration"].as<unsigned long>() );
+      }
+
+      if (json.containsKey("easing")) {
+        m_device->setTransitionEasing( Transition::easingFromName( json["easing"].as<const char*>() ) );
+      }
     }
 
     /* Time */
@@ -176,23 +216,21 @@ void DeviceMqttClient::onMqttMessage(char* topic, char* payload, AsyncMqttClient
         idIsDefined = true;
       }
 
-      std::vector<byte> icon;
-      if (json.containsKey("icon")) {
-        JsonArray &iconArray = json["icon"];
-        if (iconArray.size() == 8) {
-          for (auto &byteValue : iconArray) {
-            icon.push_back(byteValue.as<byte>());
-          }
-        }
-      }
+      AnimatedIcon icon = parseIcon(json);
 
-      std::string textString = "";
-      if (json.containsKey("text")) {
+      // The text stays in the JSON buffer, the device decodes it into its record
+      const char *textString = "";
+      if (json["text"].is<const char*>()) {
         textString = json["text"].as<const char*>();
       }
 
+      FontStyle font = FontStyle::Fixed;
+      if (json.containsKey("font")) {
+        font = Typeface::fromName( json["font"].as<const char*>() );
+      }
+
       if (idIsDefined) {
-        m_device->setScreen(id, icon, textString);
+        m_device->setScreen(id, icon, textString, font);
       }
     }
 
@@ -202,8 +240,60 @@ void DeviceMqttClient::onMqttMessage(char* topic, char* payload, AsyncMqttClient
 }
 
 
+AnimatedIcon DeviceMqttClient::parseIcon(JsonObject &json) {
+  AnimatedIcon icon;
+  if (!json.containsKey("icon")) {
+    return icon;
+  }
+
+  // The arrays are read into buffers on the stack, an icon message does not allocate
+  JsonArray &iconArray = json["icon"];
+  size_t size = iconArray.size();
+  byte frames[AnimatedIcon::MAX_FRAMES * 8];
+  if (size <= sizeof(frames)) {
+    for (size_t i = 0; i < size; i++) {
+      frames[i] = iconArray[i].as<byte>();
+    }
+  }
+
+  uint16_t durations[AnimatedIcon::MAX_FRAMES];
+  size_t durationCount = 0;
+  if (json.containsKey("durations")) {
+    JsonArray &durationArray = json["durations"];
+    for (auto &duration : durationArray) {
+      if (durationCount == AnimatedIcon::MAX_FRAMES) {
+        break;
+      }
+      durations[durationCount++] = duration.as<uint16_t>();
+    }
+  }
+
+  // A longer icon is rejected by its size, the buffer is not read
+  if (!icon.setFrames(frames, size, durations, durationCount)) {
+    Serial.printf("MQTT: The icon has %d bytes, expected up to %d frames of 8 bytes with up to %d bytes of changes\n",
+                  size, AnimatedIcon::MAX_FRAMES, AnimatedIcon::MAX_DELTA_BYTES);
+  }
+
+  // The dim bitplane of a greyscale icon
+  if (json.containsKey("shade")) {
+    JsonArray &shadeArray = json["shade"];
+    byte shade[8];
+    size_t shadeSize = shadeArray.size();
+    if (shadeSize == sizeof(shade)) {
+      for (size_t i = 0; i < shadeSize; i++) {
+        shade[i] = shadeArray[i].as<byte>();
+      }
+    }
+    if (!icon.setShade(shade, shadeSize)) {
+      Serial.printf("MQTT: The shade must have 8 bytes for an icon of one frame\n");
+    }
+  }
+  return icon;
+}
+
+
 void DeviceMqttClient::publishDeviceState() {
-  const int BUFFER_SIZE = JSON_OBJECT_SIZE(20);
+  const int BUFFER_SIZE = JSON_OBJECT_SIZE(30);
   StaticJsonBuffer<BUFFER_SIZE> jsonBuffer;
 
   JsonObject& root = jsonBuffer.createObject();
@@ -238,6 +328,48 @@ void DeviceMqttClient::publishDeviceState() {
   // Firmware version
   root["version"] = FIRMWARE_VERSION;
 
+  // Duration of the last frame transmission to the LED matrixes
+  root["displayUs"] = m_device->displayMicros();
+
+  // Notifications waiting in the queue and dropped ones (evicted, rejected or expired)
+  root["notificationsQueued"] = m_device->queuedNotifications();
+  root["notificationsDropped"] = m_device->droppedNotifications();
+
+  // Screens in the rotation and screens with a new id rejected because all SCREEN_CAPACITY slots were taken
+  root["screens"] = m_device->screenCount();
+  root["screensRejected"] = m_device->rejectedScreens();
+
+  // Software clock: RTC reads, syncs, the offset at the last sync (ms) and the drift of millis() (ppm)
+  root["rtcReads"] = SoftClock::rtcReads();
+  root["rtcSyncs"] = SoftClock::syncs();
+  root["clockOffsetMs"] = SoftClock::offset();
+  root["clockDriftPpm"] = SoftClock::drift();
+
+  // How late the clock ticked after the second boundary since the previous state (ms)
+  float jitter;
+  uint16_t jitterMax;
+  m_device->measureClockJitter(jitter, jitterMax);
+  root["clockJitterMs"] = jitter;
+  root["clockJitterMaxMs"] = jitterMax;
+
+  // Heap: free memory, the largest block which can be allocated and the fragmentation in percent
+  root["heapFree"] = ESP.getFreeHeap();
+  root["heapMaxBlock"] = ESP.getMaxFreeBlockSize();
+  root["heapFragmentation"] = ESP.getHeapFragmentation();
+
+  // Load since the previous state: SPI duty cycle and the time left to the loop, in percent
+  float spiDuty, headroom;
+  m_device->measureLoad(spiDuty, headroom);
+  root["spiDuty"] = spiDuty;
+  root["loopHeadroom"] = headroom;
+
+  // Frames received by UDP
+  if (m_stream) {
+    root["streamFrames"] = m_stream->framesShown();
+    root["streamDropped"] = m_stream->framesDropped();
+    root["streamFps"] = m_stream->fps();
+  }
+
   char buffer[root.measureLength() + 1];
   root.printTo(buffer, sizeof(buffer));
 
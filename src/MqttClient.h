@@ -6,9 +6,10 @@
 #include <ArduinoJson.h>          // https://github.com/bblanchon/ArduinoJson (ver: 5.x)
 
 #include <functional>
-#include <vector>
 
 #include "Config.h"
+#include "AnimatedIcon.h"
+#include "FrameStream.h"
 
 /*
  * The structure of the JSON document:
@@ -17,7 +18,8 @@
  *   "ip": "192.168.1.110",
  *   "mac": "11:22:33:44:55:66",
  *   "rssi": "-67",
- *   "uptime": "12:23:33"
+ *   "uptime": "12:23:33",
+ *   "displayUs": 180
  * }
  */
 class LEDMatrixDevice;
@@ -42,12 +44,21 @@ public:
     m_device = device;
   }
 
+  /* Set a stream of frames, its statistics are published with the state */
+  void setFrameStream(FrameStream *stream) {
+    m_stream = stream;
+  }
+
 private:
   void onMqttConnect(bool sessionPresent);
   void onMqttDisconnect(AsyncMqttClientDisconnectReason reason);
   void onMqttMessage(char* topic, char* payload, AsyncMqttClientMessageProperties properties, size_t len, size_t index, size_t total);
 
+  /* Reads the frames of an icon ("icon", 8 bytes per frame) and their durations ("durations") */
+  AnimatedIcon parseIcon(JsonObject &json);
+
   LEDMatrixDevice *m_device = nullptr;
+  FrameStream *m_stream = nullptr;
 };
 
 
@@ -0,0 +1,109 @@
+#include "NotificationQueue.h"
+#include <cstring>
+
+
+Notification* NotificationQueue::insert( uint8_t priority, bool keepFront )
+{
+  uint8_t first = (keepFront && m_count > 0) ? 1 : 0;
+
+  if (!keepFront && (m_count > 1)) {
+    // A front which has been kept goes back among the others, first of its priority
+    Notification *front = m_order[0];
+    uint8_t i = 0;
+    while ((i + 1 < m_count) && (m_order[i + 1]->priority > front->priority)) {
+      m_order[i] = m_order[i + 1];
+      i++;
+    }
+    m_order[i] = front;
+  }
+
+  if (m_count == CAPACITY) {
+    // The oldest of the lowest priority makes room, the front on the display is kept
+    uint8_t victim = CAPACITY;
+    for (uint8_t i = first; i < m_count; i++) {
+      if ((victim == CAPACITY) || (m_order[i]->priority < m_order[victim]->priority)) {
+        victim = i;
+      }
+    }
+    if ((victim == CAPACITY) || (m_order[victim]->priority > priority)) {
+      m_dropped++;
+      return nullptr;
+    }
+    removeAt(victim);
+    m_dropped++;
+  }
+
+  // After all notifications of the same or a higher priority
+  uint8_t position = first;
+  while ((position < m_count) && (m_order[position]->priority >= priority)) {
+    position++;
+  }
+
+  Notification *notification = m_pool.acquire();
+  for (uint8_t i = m_count; i > position; i--) {
+    m_order[i] = m_order[i - 1];
+  }
+  m_order[position] = notification;
+  m_count++;
+
+  notification->priority = priority;
+  return notification;
+}
+
+
+Notification* NotificationQueue::find( const char *key )
+{
+  if ((key == nullptr) || (key[0] == 0)) {
+    return nullptr;
+  }
+
+  for (uint8_t i = 0; i < m_count; i++) {
+    if (strncmp(m_order[i]->key, key, NOTIFICATION_KEY_CAPACITY - 1) == 0) {
+      return m_order[i];
+    }
+  }
+  return nullptr;
+}
+
+
+void NotificationQueue::pop()
+{
+  if (m_count > 0) {
+    removeAt(0);
+  }
+}
+
+
+void NotificationQueue::remove( Notification *notification )
+{
+  for (uint8_t i = 0; i < m_count; i++) {
+    if (m_order[i] == notification) {
+      removeAt(i);
+      return;
+    }
+  }
+}
+
+
+void NotificationQueue::removeExpired( unsigned long now, bool keepFront )
+{
+  uint8_t i = keepFront ? 1 : 0;
+  while (i < m_count) {
+    if (expired(*m_order[i], now)) {
+      removeAt(i);
+      m_dropped++;
+    } else {
+      i++;
+    }
+  }
+}
+
+
+void NotificationQueue::removeAt( uint8_t position )
+{
+  m_pool.release(m_order[position]);
+  m_count--;
+  for (uint8_t i = position; i < m_count; i++) {
+    m_order[i] = m_order[i + 1];
+  }
+}
@@ -0,0 +1,88 @@
+#ifndef ESP_INFORMER_NOTIFICATION_QUEUE_H
+#define ESP_INFORMER_NOTIFICATION_QUEUE_H
+
+#include <Arduino.h>
+#include "Config.h"
+#include "Typeface.h"
+#include "AnimatedIcon.h"
+#include "Pool.h"
+
+/* Texts are kept as code points, they are decoded from UTF-8 once when received */
+struct Notification
+{
+  AnimatedIcon icon;
+  char16_t text[MESSAGE_TEXT_CAPACITY];
+  uint8_t textLength = 0;
+  FontStyle font = FontStyle::Fixed;
+  int timeout = 0;
+
+  uint8_t priority = 0;                       // a higher value is more urgent
+  unsigned long expires = 0;                  // millis() after which it is dropped, 0 - never
+  char key[NOTIFICATION_KEY_CAPACITY] = {};   // a new notification with the same key replaces it
+};
+
+/* Optional delivery fields of a notification */
+struct NotificationOptions
+{
+  uint8_t priority = 0;
+  bool preempt = false;         // takes the place of the notification on the display if that one has a lower priority
+  unsigned long ttl = 0;        // seconds until it is dropped, 0 - never
+  const char *key = nullptr;    // replaces a queued notification with the same key
+};
+
+/*
+ * Notifications by priority, in the order they have arrived within a priority.
+ * The front is the one on the display, it keeps its place while the others are
+ * sorted behind it. The records are taken from a pool of
+ * NOTIFICATION_CAPACITY, which is the limit of both the depth and the memory:
+ * a notification does not allocate memory.
+ */
+class NotificationQueue
+{
+public:
+  static const uint8_t CAPACITY = NOTIFICATION_CAPACITY;
+
+  /*
+   * A new record for a notification with the priority, nullptr if it is rejected.
+   * If keepFront is true, the front stays where it is whatever the priority.
+   * A full queue evicts its oldest notification of the lowest priority,
+   * unless the new one has a lower priority still.
+   */
+  Notification* insert( uint8_t priority, bool keepFront );
+
+  /* The notification with the key, nullptr if there is none */
+  Notification* find( const char *key );
+
+  /* The first notification, the queue must not be empty */
+  Notification& front() { return *m_order[0]; }
+
+  /* Removes the first notification */
+  void pop();
+
+  /* Removes a notification of the queue */
+  void remove( Notification *notification );
+
+  /* Removes the notifications which have expired at now, except the front if keepFront is true */
+  void removeExpired( unsigned long now, bool keepFront );
+
+  static bool expired( const Notification &notification, unsigned long now ) {
+    return notification.expires && ((long)(now - notification.expires) >= 0);
+  }
+
+  bool empty() const { return m_count == 0; }
+  uint8_t size() const { return m_count; }
+
+  /* Notifications which have been evicted, rejected or have expired */
+  uint32_t dropped() const { return m_dropped; }
+
+private:
+  /* Removes the notification at the position */
+  void removeAt( uint8_t position );
+
+  Pool<Notification, CAPACITY> m_pool;
+  Notification *m_order[CAPACITY];
+  uint8_t m_count = 0;
+  uint32_t m_dropped = 0;
+};
+
+#endif //ESP_INFORMER_NOTIFICATION_QUEUE_H
@@ -0,0 +1,45 @@
+#ifndef ESP_INFORMER_POOL_H
+#define ESP_INFORMER_POOL_H
+
+#include <Arduino.h>
+
+/*
+ * N objects of the same type in one block, N <= 32.
+ * Records which come and go are taken from the pool instead of the heap,
+ * so they never leave holes of different sizes in it.
+ */
+template<typename T, uint8_t N>
+class Pool
+{
+public:
+  static constexpr uint8_t CAPACITY = N;
+
+  /* A free object reset to T(), nullptr if all of them are taken */
+  T* acquire()
+  {
+    for (uint8_t i = 0; i < N; i++) {
+      if (!(m_used & (1UL << i))) {
+        m_used |= (1UL << i);
+        m_objects[i] = T();
+        return &m_objects[i];
+      }
+    }
+    return nullptr;
+  }
+
+  /* Returns an object taken by acquire() to the pool */
+  void release( T *object )
+  {
+    m_used &= ~(1UL << (object - m_objects));
+  }
+
+  uint8_t available() const { return N - __builtin_popcount(m_used); }
+
+private:
+  static_assert(N <= 32, "a pool has up to 32 objects");
+
+  T m_objects[N];
+  uint32_t m_used = 0;    // a bit per object
+};
+
+#endif //ESP_INFORMER_POOL_H
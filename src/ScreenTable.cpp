@@ -0,0 +1,33 @@
+#include "ScreenTable.h"
+#include <cstring>
+
+
+ScreenTable::ScreenTable()
+{
+  memset(m_positions, NO_POSITION, sizeof(m_positions));
+}
+
+
+Screen* ScreenTable::find( uint8_t id )
+{
+  uint8_t position = m_positions[id];
+  return position == NO_POSITION ? nullptr : &m_slots[position];
+}
+
+
+Screen* ScreenTable::insert( uint8_t id )
+{
+  Screen *screen = find(id);
+  if (screen) {
+    return screen;
+  }
+  if (m_count == CAPACITY) {
+    m_rejected++;
+    return nullptr;
+  }
+
+  m_positions[id] = m_count;
+  screen = &m_slots[m_count++];
+  screen->id = id;
+  return screen;
+}
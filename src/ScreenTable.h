@@ -0,0 +1,57 @@
+#ifndef ESP_INFORMER_SCREEN_TABLE_H
+#define ESP_INFORMER_SCREEN_TABLE_H
+
+#include <Arduino.h>
+#include "Config.h"
+#include "Typeface.h"
+#include "AnimatedIcon.h"
+
+struct Screen
+{
+  uint8_t id;
+  AnimatedIcon icon;
+  char16_t text[MESSAGE_TEXT_CAPACITY];
+  uint8_t textLength = 0;
+  FontStyle font = FontStyle::Fixed;
+};
+
+/*
+ * Screens in a fixed number of slots, looked up by the 8-bit id through a table
+ * of 256 bytes. Slots are taken in the order the screens arrive, which is the
+ * order they are shown in. An update of a screen rewrites its slot in place.
+ * A screen keeps its icon and text inside the slot, so the table never allocates.
+ * A screen with a new id is rejected when all slots are taken.
+ */
+class ScreenTable
+{
+public:
+  static const uint8_t CAPACITY = SCREEN_CAPACITY;
+  static const uint8_t NO_POSITION = 0xFF;
+
+  ScreenTable();
+
+  /* The screen with the id or nullptr */
+  Screen* find( uint8_t id );
+
+  /* The screen with the id, a new one is added at the end. nullptr if the table is full (counted in rejected()) */
+  Screen* insert( uint8_t id );
+
+  uint8_t size() const { return m_count; }
+  bool empty() const { return m_count == 0; }
+  uint32_t rejected() const { return m_rejected; }
+
+  /* Screen at a position of the rotation, position < size() */
+  Screen& at( uint8_t position ) { return m_slots[position]; }
+
+  /* Position of the screen with the id in the rotation or NO_POSITION */
+  uint8_t position( uint8_t id ) const { return m_positions[id]; }
+
+private:
+  Screen m_slots[CAPACITY];
+  uint8_t m_count = 0;
+  uint32_t m_rejected = 0;
+
+  uint8_t m_positions[256];   // position of every id, NO_POSITION if there is none
+};
+
+#endif //ESP_INFORMER_SCREEN_TABLE_H
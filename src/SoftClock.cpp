@@ -0,0 +1,243 @@
+#include "SoftClock.h"
+#include "DS1302RTC.h"
+
+unsigned long SoftClock::s_interval = 3600000;
+unsigned long SoftClock::s_lastSync = 0;
+bool SoftClock::s_due = true;
+bool SoftClock::s_locked = false;
+uint8_t SoftClock::s_failures = 0;
+
+uint8_t SoftClock::s_searchSeconds = 0;
+unsigned long SoftClock::s_searchMillis = 0;
+unsigned long SoftClock::s_searchStart = 0;
+bool SoftClock::s_driftValid = false;
+
+time_t SoftClock::s_baseTime = 0;
+unsigned long SoftClock::s_baseMillis = 0;
+int32_t SoftClock::s_driftPpb = 0;
+
+uint32_t SoftClock::s_reads = 0;
+uint32_t SoftClock::s_syncs = 0;
+int32_t SoftClock::s_offset = 0;
+
+// The drift correction is limited to what crystals can do
+static const int32_t MAX_DRIFT_PPB = 500000;
+
+// Shorter intervals between syncs do not tell the drift from the polling error
+static const unsigned long MIN_DRIFT_INTERVAL = 60000;
+
+// The seconds register has not been read by the search yet
+static const uint8_t NO_SECONDS = 0xFF;
+
+
+void SoftClock::begin( unsigned long syncInterval )
+{
+  s_interval = syncInterval;
+  s_baseMillis = millis();
+  if (!syncEdge(FULL_WINDOW)) {
+    // No second boundary: the RTC is halted or missing, its time is taken as it is
+    s_reads++;
+    s_baseTime = DS1302RTC::get();
+    s_baseMillis = millis();
+    syncFailed();
+  }
+}
+
+
+unsigned long SoftClock::elapsed( unsigned long ms )
+{
+  unsigned long e = ms - s_baseMillis;
+  return e - (int32_t)(((int64_t)e * s_driftPpb) / 1000000000LL);
+}
+
+
+time_t SoftClock::now()
+{
+  return s_baseTime + elapsed(millis()) / 1000;
+}
+
+
+time_t SoftClock::now( uint16_t &millisOfSecond )
+{
+  unsigned long e = elapsed(millis());
+  millisOfSecond = e % 1000;
+  return s_baseTime + e / 1000;
+}
+
+
+uint16_t SoftClock::millisOfSecond()
+{
+  return elapsed(millis()) % 1000;
+}
+
+
+unsigned long SoftClock::interval()
+{
+  return (s_failures > 0) && (s_failures <= SYNC_RETRIES) ? RETRY_INTERVAL : s_interval;
+}
+
+
+unsigned long SoftClock::untilSync()
+{
+  unsigned long ms = millis();
+  if (!s_due && (ms - s_lastSync < interval())) {
+    return interval() - (ms - s_lastSync);
+  }
+
+  if (!s_locked) {
+    bool started = s_searchSeconds != NO_SECONDS;
+    return started && (ms - s_searchMillis < SEARCH_STEP) ? SEARCH_STEP - (ms - s_searchMillis) : 0;
+  }
+
+  // Polling starts half a window before the expected boundary
+  unsigned long toEdge = 1000 - elapsed(ms) % 1000;
+  return toEdge > SYNC_WINDOW / 2 ? toEdge - SYNC_WINDOW / 2 : 0;
+}
+
+
+void SoftClock::run()
+{
+  if (untilSync() > 0) {
+    return;
+  }
+
+  if (!s_locked) {
+    searchEdge();
+    return;
+  }
+
+  unsigned long toEdge = 1000 - elapsed(millis()) % 1000;
+  if (!syncEdge(toEdge + SYNC_WINDOW / 2)) {
+    // The clock is further off than the window: the boundary is searched for
+    s_locked = false;
+    s_searchSeconds = NO_SECONDS;
+  }
+}
+
+
+void SoftClock::set( time_t t )
+{
+  s_baseTime = t;
+  s_baseMillis = millis();
+  s_due = true;
+  s_locked = false;
+  s_searchSeconds = NO_SECONDS;
+  s_failures = 0;
+  s_driftValid = false;
+}
+
+
+void SoftClock::syncFailed()
+{
+  s_lastSync = millis();
+  s_due = false;
+  s_locked = false;
+  s_searchSeconds = NO_SECONDS;
+  if (s_failures <= SYNC_RETRIES) {
+    s_failures++;
+  }
+}
+
+
+void SoftClock::searchEdge()
+{
+  unsigned long ms = millis();
+  uint8_t seconds = readSeconds();
+  if (s_searchSeconds == NO_SECONDS) {
+    s_searchSeconds = seconds;
+    s_searchStart = ms;
+    s_searchMillis = ms;
+    return;
+  }
+
+  if (seconds == s_searchSeconds) {
+    s_searchMillis = ms;
+    if (ms - s_searchStart >= FULL_WINDOW) {
+      // No second boundary: the RTC is halted or missing
+      syncFailed();
+    }
+    return;
+  }
+
+  if (ms - s_searchMillis > SYNC_WINDOW / 2) {
+    // The reads are too far apart to find the boundary in the window, the search waits for the next one
+    s_searchSeconds = seconds;
+    s_searchStart = ms;
+    s_searchMillis = ms;
+    return;
+  }
+
+  // A new second has started since the previous read. Its start is taken halfway,
+  // the sync at the next boundary finds it to a millisecond.
+  s_reads++;
+  time_t t = DS1302RTC::get();
+  if (t == 0) {
+    syncFailed();
+    return;
+  }
+  s_baseTime = t;
+  s_baseMillis = s_searchMillis + (ms - s_searchMillis) / 2;
+  s_driftValid = false;
+  s_locked = true;
+  s_due = true;
+}
+
+
+uint8_t SoftClock::readSeconds()
+{
+  s_reads++;
+  return DS1302RTC::readRTC(DS1302_SECONDS);
+}
+
+
+bool SoftClock::syncEdge( unsigned long limit )
+{
+  unsigned long start = millis();
+  uint8_t first = readSeconds();
+  uint8_t seconds = first;
+  unsigned long edge = start;
+  while ((seconds == first) && (millis() - start < limit)) {
+    edge = millis();
+    seconds = readSeconds();
+    yield();
+  }
+  if (seconds == first) {
+    return false;
+  }
+
+  // A new second has started at edge, the burst read gets the whole time within it
+  s_reads++;
+  time_t t = DS1302RTC::get();
+  if (t == 0) {
+    syncFailed();
+    return true;
+  }
+
+  // Where the clock was at the boundary, and the drift which explains it.
+  // The base must be a boundary found by a sync.
+  if (s_driftValid) {
+    unsigned long e = edge - s_baseMillis;
+    int64_t predicted = (int64_t)s_baseTime * 1000 + elapsed(edge);
+    s_offset = (int32_t)(predicted - (int64_t)t * 1000);
+
+    if ((e >= MIN_DRIFT_INTERVAL) && (s_offset > -1000) && (s_offset < 1000)) {
+      int64_t drift = s_driftPpb + (int64_t)s_offset * 1000000000LL / e;
+      if (drift > MAX_DRIFT_PPB) {
+        drift = MAX_DRIFT_PPB;
+      } else if (drift < -MAX_DRIFT_PPB) {
+        drift = -MAX_DRIFT_PPB;
+      }
+      s_driftPpb = drift;
+    }
+  }
+  s_driftValid = true;
+
+  s_baseTime = t;
+  s_baseMillis = edge;
+  s_lastSync = edge;
+  s_due = false;
+  s_locked = true;
+  s_failures = 0;
+  s_syncs++;
+  return true;
+}
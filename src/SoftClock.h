@@ -0,0 +1,107 @@
+#ifndef ESP_INFORMER_SOFT_CLOCK_H
+#define ESP_INFORMER_SOFT_CLOCK_H
+
+#include <Arduino.h>
+#include <Time.h>
+
+/*
+ * Time of day from millis(), disciplined by the DS1302.
+ *
+ * The RTC is read at begin() and then every sync interval, nothing else touches its bus.
+ * A sync polls the seconds register around the second boundary the clock expects and
+ * takes the moment it changes as the start of the second, so the clock keeps the phase
+ * of the RTC to a millisecond. The difference found at every sync corrects the drift
+ * of millis() against the RTC between syncs.
+ *
+ * Only begin() waits for a whole second. Later a sync polls SYNC_WINDOW at most; if the
+ * boundary is not in the window, it is searched for by reading the seconds register once
+ * every SEARCH_STEP from run(). A failed sync (a halted or missing RTC) is retried after
+ * RETRY_INTERVAL a few times, then after the sync interval.
+ *
+ * All members are static like the RTC library, so now() is a plain time source.
+ */
+class SoftClock
+{
+public:
+  /* Reads the RTC, waiting for the start of a second (up to a second) */
+  static void begin( unsigned long syncInterval );
+
+  /* Current time, it never reads the RTC */
+  static time_t now();
+
+  /* Current time and the milliseconds since the start of its second, from one reading of millis() */
+  static time_t now( uint16_t &millisOfSecond );
+
+  /* Milliseconds since the start of the current second */
+  static uint16_t millisOfSecond();
+
+  /* Syncs with the RTC if it is due and the second boundary is near. It is called from loop() */
+  static void run();
+
+  /* Milliseconds until run() must be called for a due sync */
+  static unsigned long untilSync();
+
+  /* The RTC has been set to t: the clock follows at once and syncs at the next run() */
+  static void set( time_t t );
+
+  /* Statistics */
+  static uint32_t rtcReads() { return s_reads; }
+  static uint32_t syncs() { return s_syncs; }
+  static int32_t offset() { return s_offset; }             // ms the clock was ahead of the RTC at the last sync
+  static float drift() { return s_driftPpb / 1000.0f; }    // ppm millis() runs faster than the RTC
+
+  /* Polling window at the expected second boundary and the longest search for a boundary */
+  static const unsigned long SYNC_WINDOW = 50;
+  static const unsigned long FULL_WINDOW = 1100;
+
+  /* Milliseconds between the reads of a search */
+  static const unsigned long SEARCH_STEP = 10;
+
+  /* A failed sync is retried after RETRY_INTERVAL up to SYNC_RETRIES times */
+  static const unsigned long RETRY_INTERVAL = 5000;
+  static const uint8_t SYNC_RETRIES = 3;
+
+private:
+  /* Milliseconds since the base second with the drift removed */
+  static unsigned long elapsed( unsigned long ms );
+
+  /* The interval to the next sync, shorter after a failure */
+  static unsigned long interval();
+
+  /*
+   * Polls the seconds register for up to limit ms. Returns false if no new second has started,
+   * a second which has started with an invalid time is a failed sync.
+   */
+  static bool syncEdge( unsigned long limit );
+
+  /* One read of a search, it takes the start of a new second as the base of the clock */
+  static void searchEdge();
+
+  /* The sync has failed, the next one is due after the retry interval */
+  static void syncFailed();
+
+  static uint8_t readSeconds();
+
+  static unsigned long s_interval;
+  static unsigned long s_lastSync;
+  static bool s_due;
+  static bool s_locked;           // the boundary is within SYNC_WINDOW, otherwise it is searched for
+  static uint8_t s_failures;      // failed syncs in a row
+
+  /* The search: the seconds register at its previous read, the time of that read and of the first one */
+  static uint8_t s_searchSeconds;
+  static unsigned long s_searchMillis;
+  static unsigned long s_searchStart;
+
+  static bool s_driftValid;       // the base is a second boundary found by a sync
+
+  static time_t s_baseTime;       // the second which started at s_baseMillis
+  static unsigned long s_baseMillis;
+  static int32_t s_driftPpb;
+
+  static uint32_t s_reads;
+  static uint32_t s_syncs;
+  static int32_t s_offset;
+};
+
+#endif //ESP_INFORMER_SOFT_CLOCK_H
@@ -0,0 +1,219 @@
+#include "Transition.h"
+#include <cstring>
+#include "LEDMatrixDriver.h"
+
+
+Transition::Transition( uint8_t nsegments ) :
+  m_nsegments(nsegments)
+{
+}
+
+
+Transition::~Transition()
+{
+  if (m_outgoing) {
+    delete[] m_outgoing;
+  }
+
+  if (m_incoming) {
+    delete[] m_incoming;
+  }
+
+  if (m_rows) {
+    delete[] m_rows;
+  }
+}
+
+
+Transition::Effect Transition::effectFromName( const char *name )
+{
+  if (name == nullptr) {
+    return Effect::None;
+  }
+  if (strcmp(name, "slideUp") == 0) {
+    return Effect::SlideUp;
+  }
+  if (strcmp(name, "slideDown") == 0) {
+    return Effect::SlideDown;
+  }
+  if (strcmp(name, "wipe") == 0) {
+    return Effect::Wipe;
+  }
+  if (strcmp(name, "pushLeft") == 0) {
+    return Effect::PushLeft;
+  }
+  if (strcmp(name, "fade") == 0) {
+    return Effect::Fade;
+  }
+  return Effect::None;
+}
+
+
+Transition::Easing Transition::easingFromName( const char *name )
+{
+  if (name == nullptr) {
+    return Easing::Linear;
+  }
+  if (strcmp(name, "easeOut") == 0) {
+    return Easing::EaseOut;
+  }
+  if (strcmp(name, "easeInOut") == 0) {
+    return Easing::EaseInOut;
+  }
+  return Easing::Linear;
+}
+
+
+void Transition::captureOutgoing( LEDMatrixDriver *driver )
+{
+  // The frames are allocated with the first transition
+  if (m_outgoing == nullptr) {
+    m_outgoing = new uint8_t[8 * m_nsegments];
+    m_incoming = new uint8_t[8 * m_nsegments];
+    m_rows = new uint8_t[2 * m_nsegments];
+  }
+
+  for (uint8_t y = 0; y < 8; y++) {
+    driver->readRow(y, m_outgoing + y * m_nsegments);
+  }
+}
+
+
+void Transition::start( LEDMatrixDriver *driver, unsigned long now )
+{
+  for (uint8_t y = 0; y < 8; y++) {
+    driver->readRow(y, m_incoming + y * m_nsegments);
+  }
+
+  m_active = true;
+  m_start = now;
+  m_lastStep = -1;
+}
+
+
+uint16_t Transition::progress( unsigned long now ) const
+{
+  unsigned long elapsed = now - m_start;
+  if (elapsed >= m_duration) {
+    return 256;
+  }
+
+  // Fixed point, 256 is the end of the transition. elapsed << 8 needs more than 32 bits for long durations
+  uint32_t q = ((uint64_t)elapsed << 8) / m_duration;
+  switch (m_easing) {
+    case Easing::EaseOut:
+      return 256 - ((256 - q) * (256 - q) >> 8);
+    case Easing::EaseInOut:
+      return (q * q * (768 - 2 * q)) >> 16;
+    default:
+      return q;
+  }
+}
+
+
+bool Transition::step( LEDMatrixDriver *driver, unsigned long now, uint8_t brightness )
+{
+  if (!m_active) {
+    return false;
+  }
+
+  uint16_t q = progress(now);
+
+  if (m_effect == Effect::Fade) {
+    // Down with the old frame and up with the new one. Intensity 0 is still lit,
+    // so the display is shut down at the low point. The registers are shadowed, steps cost nothing.
+    uint16_t level = q < 128 ? (brightness + 1) * (128 - q) / 128 : (brightness + 1) * (q - 128) / 128;
+    driver->setEnabled(level > 0);
+    if (level > 0) {
+      driver->setBrightness(level - 1);
+    }
+  }
+
+  if (q != m_lastStep) {
+    compose(driver, q);
+    m_lastStep = q;
+  }
+
+  if (q < 256) {
+    return true;
+  }
+
+  m_active = false;
+  driver->setEnabled(true);
+  driver->setBrightness(brightness);
+  return false;
+}
+
+
+void Transition::cancel( LEDMatrixDriver *driver, uint8_t brightness )
+{
+  if (m_active) {
+    m_active = false;
+    driver->setEnabled(true);
+    driver->setBrightness(brightness);
+  }
+}
+
+
+void Transition::compose( LEDMatrixDriver *driver, uint16_t q )
+{
+  uint8_t n = m_nsegments;
+  uint16_t width = 8 * n;
+  uint8_t *row = m_rows;
+  uint8_t *other = m_rows + n;
+
+  for (uint8_t y = 0; y < 8; y++) {
+    const uint8_t *out = m_outgoing + y * n;
+    const uint8_t *in = m_incoming + y * n;
+
+    switch (m_effect) {
+      case Effect::SlideUp: {
+        uint8_t k = (q * 8) >> 8;
+        uint8_t src = y + k;
+        driver->writeRow(y, src < 8 ? m_outgoing + src * n : m_incoming + (src - 8) * n);
+        break;
+      }
+
+      case Effect::SlideDown: {
+        uint8_t k = (q * 8) >> 8;
+        driver->writeRow(y, y < k ? m_incoming + (8 - k + y) * n : m_outgoing + (y - k) * n);
+        break;
+      }
+
+      case Effect::Wipe: {
+        uint16_t boundary = ((uint32_t)q * width) >> 8;
+        for (uint8_t i = 0; i < n; i++) {
+          uint8_t mask;
+          if (8 * (i + 1) <= boundary) {
+            mask = 0xFF;
+          } else if (8 * i >= boundary) {
+            mask = 0;
+          } else {
+            mask = 0xFF << (8 - (boundary - 8 * i));
+          }
+          row[i] = (in[i] & mask) | (out[i] & ~mask);
+        }
+        driver->writeRow(y, row);
+        break;
+      }
+
+      case Effect::PushLeft: {
+        uint16_t k = ((uint32_t)q * width) >> 8;
+        memcpy(row, out, n);
+        LEDMatrixDriver::shiftRowLeft(row, n, k);
+        memcpy(other, in, n);
+        LEDMatrixDriver::shiftRowRight(other, n, width - k);
+        for (uint8_t i = 0; i < n; i++) {
+          row[i] |= other[i];
+        }
+        driver->writeRow(y, row);
+        break;
+      }
+
+      default:
+        // Fade and the end of every effect: one of the frames
+        driver->writeRow(y, q < 128 && m_effect == Effect::Fade ? out : in);
+        break;
+    }
+  }
+}
@@ -0,0 +1,90 @@
+#ifndef ESP_INFORMER_TRANSITION_H
+#define ESP_INFORMER_TRANSITION_H
+
+#include <Arduino.h>
+
+class LEDMatrixDriver;
+
+/*
+ * An animated change from the frame on the display to a new one.
+ *
+ * Both frames are captured once, every step only combines their rows into
+ * the framebuffer, so the content is not rasterised again during the transition.
+ * A step is a few byte operations per row and the loop is never blocked.
+ */
+class Transition
+{
+public:
+  enum class Effect : uint8_t {
+    None,
+    SlideUp,      // the new frame comes from the bottom
+    SlideDown,    // the new frame comes from the top
+    Wipe,         // the new frame is uncovered from the left
+    PushLeft,     // the new frame pushes the old one out to the left
+    Fade          // the brightness goes down with the old frame to dark and up with the new one
+  };
+
+  enum class Easing : uint8_t {
+    Linear,
+    EaseOut,
+    EaseInOut
+  };
+
+  /* Milliseconds between steps */
+  static const unsigned long STEP_PERIOD = 20;
+
+  Transition( uint8_t nsegments );
+  ~Transition();
+
+  Transition( const Transition& ) = delete;
+  Transition& operator=( const Transition& ) = delete;
+
+  /* Effect names: "none", "slideUp", "slideDown", "wipe", "pushLeft", "fade" */
+  static Effect effectFromName( const char *name );
+  /* Easing names: "linear", "easeOut", "easeInOut" */
+  static Easing easingFromName( const char *name );
+
+  void setEffect( Effect effect ) { m_effect = effect; }
+  void setDuration( unsigned long duration ) { m_duration = duration; }
+  void setEasing( Easing easing ) { m_easing = easing; }
+  Effect effect() const { return m_effect; }
+
+  /* Saves the frame which is on the display */
+  void captureOutgoing( LEDMatrixDriver *driver );
+
+  /* Saves the rendered new frame and starts the transition with the outgoing frame */
+  void start( LEDMatrixDriver *driver, unsigned long now );
+
+  bool active() const { return m_active; }
+
+  /*
+   * Draws the step for now. Returns false when the transition has finished,
+   * then the new frame is in the framebuffer, the display is enabled and the brightness is restored.
+   */
+  bool step( LEDMatrixDriver *driver, unsigned long now, uint8_t brightness );
+
+  /* Stops the transition, the framebuffer is left as it is. The display is enabled with the brightness */
+  void cancel( LEDMatrixDriver *driver, uint8_t brightness );
+
+private:
+  /* Progress of the transition 0 - 256 after easing */
+  uint16_t progress( unsigned long now ) const;
+
+  /* Combines the rows of the frames for the progress */
+  void compose( LEDMatrixDriver *driver, uint16_t q );
+
+  const uint8_t m_nsegments;
+  Effect m_effect = Effect::None;
+  Easing m_easing = Easing::EaseInOut;
+  unsigned long m_duration = 400;
+
+  bool m_active = false;
+  unsigned long m_start = 0;
+  int16_t m_lastStep = -1;
+
+  uint8_t *m_outgoing = nullptr;    // logical rows of both frames
+  uint8_t *m_incoming = nullptr;
+  uint8_t *m_rows = nullptr;        // two rows for composing
+};
+
+#endif //ESP_INFORMER_TRANSITION_H
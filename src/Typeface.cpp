@@ -0,0 +1,229 @@
+#include "Typeface.h"
+#include <array>
+#include <cstring>
+#include "LEDMatrixDriver.h"
+#include "GlyphCache.h"
+#include "Font.h"
+
+namespace {
+
+// Horizontal extent of a glyph
+struct GlyphMetrics
+{
+  uint8_t left;       // the first column with a pixel
+  uint8_t advance;    // width of the cell
+};
+
+// Width of a space in the variable-width styles
+constexpr uint8_t SPACE_ADVANCE = 3;
+
+// Trims the empty columns of a 8x8 glyph and adds a column of gap
+constexpr GlyphMetrics metricsOf( const uint8_t *rows )
+{
+  uint8_t bits = 0;
+  for (uint8_t y = 0; y < 8; y++) {
+    bits |= rows[y];
+  }
+  if (bits == 0) {
+    return { 0, SPACE_ADVANCE };
+  }
+
+  uint8_t left = 0;
+  while (!(bits & (0x80 >> left))) {
+    left++;
+  }
+  uint8_t right = 7;
+  while (!(bits & (0x80 >> right))) {
+    right--;
+  }
+  return { left, uint8_t(right - left + 2) };
+}
+
+template<size_t N>
+constexpr std::array<GlyphMetrics, N> buildMetrics( const uint8_t (&glyphs)[N][8] )
+{
+  std::array<GlyphMetrics, N> metrics{};
+  for (size_t i = 0; i < N; i++) {
+    metrics[i] = metricsOf(glyphs[i]);
+  }
+  return metrics;
+}
+
+// Metrics of the font in flash, in the order of the glyphs
+constexpr std::array<GlyphMetrics, sizeof(font) / sizeof(font[0])> fontMetrics PROGMEM = buildMetrics(font);
+
+
+// A compact glyph as it is written: 5 rows of width pixels, LSB is the rightmost pixel
+struct CompactSource
+{
+  char16_t codepoint;
+  uint8_t width;
+  uint8_t rows[5];
+};
+
+constexpr CompactSource compactSource[] = {
+  { u'0', 3, { 0b111, 0b101, 0b101, 0b101, 0b111 } },
+  { u'1', 3, { 0b010, 0b110, 0b010, 0b010, 0b111 } },
+  { u'2', 3, { 0b111, 0b001, 0b111, 0b100, 0b111 } },
+  { u'3', 3, { 0b111, 0b001, 0b111, 0b001, 0b111 } },
+  { u'4', 3, { 0b101, 0b101, 0b111, 0b001, 0b001 } },
+  { u'5', 3, { 0b111, 0b100, 0b111, 0b001, 0b111 } },
+  { u'6', 3, { 0b111, 0b100, 0b111, 0b101, 0b111 } },
+  { u'7', 3, { 0b111, 0b001, 0b001, 0b001, 0b001 } },
+  { u'8', 3, { 0b111, 0b101, 0b111, 0b101, 0b111 } },
+  { u'9', 3, { 0b111, 0b101, 0b111, 0b001, 0b111 } },
+  { u':', 1, { 0b0, 0b1, 0b0, 0b1, 0b0 } },
+  { u' ', 1, { 0b0, 0b0, 0b0, 0b0, 0b0 } },   // as wide as ':', for the blinking delimiter
+  { u'.', 1, { 0b0, 0b0, 0b0, 0b0, 0b1 } },
+  { u'-', 3, { 0b000, 0b000, 0b111, 0b000, 0b000 } },
+  { u'+', 3, { 0b000, 0b010, 0b111, 0b010, 0b000 } },
+  { u'%', 3, { 0b101, 0b001, 0b010, 0b100, 0b101 } },
+  { u'\u00B0', 2, { 0b11, 0b11, 0b00, 0b00, 0b00 } },
+};
+
+// A compact glyph in the layout of the 8x8 font
+struct CompactGlyph
+{
+  char16_t codepoint;
+  uint8_t advance;
+  uint8_t rows[8];
+};
+
+// The top row of the compact glyphs in the cell
+constexpr uint8_t COMPACT_TOP = 1;
+
+template<size_t N>
+constexpr std::array<CompactGlyph, N> buildCompact( const CompactSource (&source)[N] )
+{
+  std::array<CompactGlyph, N> glyphs{};
+  for (size_t i = 0; i < N; i++) {
+    glyphs[i].codepoint = source[i].codepoint;
+    glyphs[i].advance = source[i].width + 1;
+    for (uint8_t y = 0; y < 5; y++) {
+      glyphs[i].rows[COMPACT_TOP + y] = source[i].rows[y] << (8 - source[i].width);
+    }
+  }
+  return glyphs;
+}
+
+constexpr std::array<CompactGlyph, sizeof(compactSource) / sizeof(compactSource[0])> compactFont PROGMEM = buildCompact(compactSource);
+
+
+// Returns the index of a compact glyph, or -1
+int compactIndex( uint16_t codepoint )
+{
+  for (size_t i = 0; i < compactFont.size(); i++) {
+    if (pgm_read_word(&compactFont[i].codepoint) == codepoint) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+GlyphMetrics proportionalMetrics( uint16_t codepoint, const uint8_t *rows )
+{
+  int idx = GlyphCache::glyphIndex(codepoint);
+  if (idx < 0) {
+    return metricsOf(rows);
+  }
+  GlyphMetrics metrics;
+  memcpy_P(&metrics, &fontMetrics[idx], sizeof(metrics));
+  return metrics;
+}
+
+} // namespace
+
+
+FontStyle Typeface::fromName( const char *name )
+{
+  if (name == nullptr) {
+    return FontStyle::Fixed;
+  }
+  if (strcmp(name, "proportional") == 0) {
+    return FontStyle::Proportional;
+  }
+  if (strcmp(name, "compact") == 0) {
+    return FontStyle::Compact;
+  }
+  return FontStyle::Fixed;
+}
+
+
+uint8_t Typeface::advance( FontStyle style, uint16_t codepoint )
+{
+  if (style == FontStyle::Fixed) {
+    return 8;
+  }
+  if (style == FontStyle::Compact) {
+    int idx = compactIndex(codepoint);
+    if (idx >= 0) {
+      return pgm_read_byte(&compactFont[idx].advance);
+    }
+  }
+  return proportionalMetrics(codepoint, LEDMatrixDriver::glyph(codepoint)).advance;
+}
+
+
+void Typeface::glyph( FontStyle style, uint16_t codepoint, uint8_t *rows )
+{
+  if (style == FontStyle::Compact) {
+    int idx = compactIndex(codepoint);
+    if (idx >= 0) {
+      memcpy_P(rows, compactFont[idx].rows, 8);
+      return;
+    }
+  }
+
+  const uint8_t *g = LEDMatrixDriver::glyph(codepoint);
+  uint8_t left = (style == FontStyle::Fixed) ? 0 : proportionalMetrics(codepoint, g).left;
+  for (uint8_t y = 0; y < 8; y++) {
+    rows[y] = g[y] << left;
+  }
+}
+
+
+int Typeface::textWidth( FontStyle style, const char16_t *text, int len )
+{
+  int width = 0;
+  for (int idx = 0; idx < len; idx++) {
+    width += advance(style, text[idx]);
+  }
+  return width;
+}
+
+
+void Typeface::clearColumns( LEDMatrixDriver *driver, int x, int width )
+{
+  static const uint8_t empty[8] = {};
+  for (; width > 0; x += 8, width -= 8) {
+    driver->drawSprite(empty, x, 0, width < 8 ? width : 8, 8);
+  }
+}
+
+
+void Typeface::drawCentered( LEDMatrixDriver *driver, FontStyle style, const char16_t *text, int len, int areaX, int areaWidth )
+{
+  int width = textWidth(style, text, len);
+  int x = areaX + (width < areaWidth ? (areaWidth - width) / 2 : 0);
+  int areaEnd = areaX + areaWidth;
+
+  clearColumns(driver, areaX, x - areaX);
+
+  uint8_t rows[8];
+  for (int idx = 0; (idx < len) && (x < areaEnd); idx++) {
+    uint8_t cell = advance(style, text[idx]);
+    glyph(style, text[idx], rows);
+    // Every cell is drawn with its gap, so nothing is left of the previous text
+    uint8_t glyphWidth = cell < 8 ? cell : 8;
+    if (x + glyphWidth > areaEnd) {
+      glyphWidth = areaEnd - x;
+    }
+    driver->drawSprite(rows, x, 0, glyphWidth, 8);
+    if (cell > 8) {
+      clearColumns(driver, x + 8, (x + cell < areaEnd ? x + cell : areaEnd) - (x + 8));
+    }
+    x += cell;
+  }
+
+  clearColumns(driver, x, areaEnd - x);
+}
@@ -0,0 +1,47 @@
+#ifndef ESP_INFORMER_TYPEFACE_H
+#define ESP_INFORMER_TYPEFACE_H
+
+#include <Arduino.h>
+
+class LEDMatrixDriver;
+
+enum class FontStyle : uint8_t
+{
+  Fixed = 0,      // 8x8 cells
+  Proportional,   // glyphs of the 8x8 font trimmed to their width
+  Compact         // 3x5 digits, other characters are proportional
+};
+
+/*
+ * Variable-width layout of text.
+ * Advance widths of the font in flash and the compact glyphs are generated at compile time,
+ * glyphs from packs on SPIFFS are measured when they are used.
+ */
+class Typeface
+{
+public:
+  /* Returns the style with the given name: "fixed", "proportional" or "compact". Fixed by default */
+  static FontStyle fromName( const char *name );
+
+  /* Width of the cell of a glyph in pixels, including the gap after the glyph */
+  static uint8_t advance( FontStyle style, uint16_t codepoint );
+
+  /* Copies 8 rows of a glyph (MSB is the leftmost pixel) aligned to the left side of its cell */
+  static void glyph( FontStyle style, uint16_t codepoint, uint8_t *rows );
+
+  /* Sum of the advance widths of the text */
+  static int textWidth( FontStyle style, const char16_t *text, int len );
+
+  /*
+   * Draws the text centered in an area of areaWidth pixels at areaX.
+   * Pixels of the area which are not covered by glyphs are cleared, so a shorter text
+   * can be drawn over a longer one without clearing the display.
+   */
+  static void drawCentered( LEDMatrixDriver *driver, FontStyle style, const char16_t *text, int len, int areaX, int areaWidth );
+
+private:
+  /* Clears the columns [x, x + width) */
+  static void clearColumns( LEDMatrixDriver *driver, int x, int width );
+};
+
+#endif //ESP_INFORMER_TYPEFACE_H
@@ -0,0 +1,55 @@
+#include "Utf8.h"
+#include <cstdint>
+#include <cstring>
+
+// Decodes the code point at text[idx] and advances idx
+static char16_t decodeNext( const char *text, size_t len, size_t &idx )
+{
+  uint8_t lead = text[idx++];
+
+  // Number of continuation bytes, the bits of the lead byte and the smallest code point
+  // of the length: a shorter one is an overlong form
+  uint8_t count = 0;
+  uint32_t codepoint = lead;
+  uint32_t minimum = 0;
+  if (lead >= 0xF0 && lead < 0xF8) {
+    count = 3;
+    codepoint = lead & 0x07;
+    minimum = 0x10000;
+  } else if (lead >= 0xE0) {
+    count = 2;
+    codepoint = lead & 0x0F;
+    minimum = 0x800;
+  } else if (lead >= 0xC0) {
+    count = 1;
+    codepoint = lead & 0x1F;
+    minimum = 0x80;
+  } else if (lead >= 0x80) {
+    return u'?'; // A continuation byte without a lead byte
+  }
+
+  bool valid = lead < 0xF8;
+  for (uint8_t i = 0; i < count && valid; i++) {
+    if ((idx < len) && ((uint8_t(text[idx]) & 0xC0) == 0x80)) {
+      codepoint = (codepoint << 6) | (uint8_t(text[idx++]) & 0x3F);
+    } else {
+      valid = false;
+    }
+  }
+
+  // Overlong forms and UTF-16 surrogates are invalid, code points above U+FFFF have no glyph
+  valid = valid && (codepoint >= minimum) && !(codepoint >= 0xD800 && codepoint <= 0xDFFF);
+  return (valid && codepoint <= 0xFFFF) ? char16_t(codepoint) : u'?';
+}
+
+
+size_t decodeUtf8( const char *text, char16_t *buffer, size_t capacity )
+{
+  size_t len = strlen(text);
+  size_t count = 0;
+  size_t idx = 0;
+  while ((idx < len) && (count < capacity)) {
+    buffer[count++] = decodeNext(text, len, idx);
+  }
+  return count;
+}
@@ -0,0 +1,15 @@
+#ifndef ESP_INFORMER_UTF8_H
+#define ESP_INFORMER_UTF8_H
+
+#include <cstddef>
+
+/*
+ * Decodes UTF-8 text into a buffer of capacity code points of the Basic Multilingual Plane.
+ * It is done once when a text is received, so rendering works with code points only.
+ * Invalid sequences (truncated, overlong, surrogates) and code points above U+FFFF become '?',
+ * the rest of a longer text is dropped.
+ * Returns the number of code points.
+ */
+size_t decodeUtf8( const char *text, char16_t *buffer, size_t capacity );
+
+#endif //ESP_INFORMER_UTF8_H
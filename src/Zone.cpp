@@ -0,0 +1,204 @@
+#include "Zone.h"
+#include <cstring>
+#include "LEDMatrixDriver.h"
+
+
+void Zone::setRect( int x, int width )
+{
+  m_x = x;
+  m_width = width;
+  invalidate();
+}
+
+
+bool Zone::due( unsigned long now ) const
+{
+  return m_changed || (m_interval && (now - m_lastRender >= m_interval));
+}
+
+
+unsigned long Zone::remaining( unsigned long now ) const
+{
+  if (m_changed) {
+    return 0;
+  }
+  if (m_interval == 0) {
+    return ~0UL;
+  }
+  unsigned long elapsed = now - m_lastRender;
+  return elapsed >= m_interval ? 0 : m_interval - elapsed;
+}
+
+
+void Zone::render( LEDMatrixDriver *driver, unsigned long now )
+{
+  draw(driver, now);
+  m_changed = false;
+  m_lastRender = now;
+}
+
+
+void IconZone::setIcon( const AnimatedIcon &icon )
+{
+  m_icon = icon;
+  m_icon.rewind();
+  setInterval(m_icon.animated() ? m_icon.duration() : 0);
+  invalidate();
+}
+
+
+void IconZone::restart( unsigned long now )
+{
+  m_icon.rewind();
+  setInterval(m_icon.animated() ? m_icon.duration() : 0);
+  invalidate();
+}
+
+
+void IconZone::draw( LEDMatrixDriver *driver, unsigned long now )
+{
+  // The timer of the zone has run out: the next frame
+  if (!m_changed && m_icon.animated()) {
+    m_icon.next();
+    setInterval(m_icon.duration());
+  }
+  driver->drawSprite(m_icon.frame(), m_x, 0, m_width < 8 ? m_width : 8, 8);
+
+  // Greyscale is dithered by the driver in the column of the icon
+  if (m_icon.shade() && (m_width >= 8) && (m_x % 8 == 0)) {
+    driver->setGreyscale(m_x / 8, 1, m_icon.frame(), m_icon.shade());
+  } else {
+    driver->clearGreyscale();
+  }
+}
+
+
+void TextZone::setText( const char16_t *text, int len, FontStyle font, unsigned long now )
+{
+  m_marquee.setText(text, len, font, m_x, m_width, now);
+  setInterval(m_marquee.scrolling() ? Marquee::PIXEL_PERIOD : 0);
+  invalidate();
+}
+
+
+void TextZone::invalidate()
+{
+  Zone::invalidate();
+  m_marquee.invalidate();
+}
+
+
+void TextZone::restart( unsigned long now )
+{
+  Zone::invalidate();
+  m_marquee.restart(now);
+}
+
+
+void TextZone::draw( LEDMatrixDriver *driver, unsigned long now )
+{
+  // The marquee skips a window which has not moved
+  m_marquee.render(driver, now);
+}
+
+
+void ClockZone::configure( FontStyle font, bool seconds, bool blink )
+{
+  m_font = font;
+  m_seconds = seconds;
+  m_blink = blink;
+  m_period = (!seconds && blink) ? 500 : 1000;
+  invalidate();
+}
+
+
+void ClockZone::invalidate()
+{
+  Zone::invalidate();
+  m_text[0] = '\0';
+}
+
+
+bool ClockZone::due( unsigned long now ) const
+{
+  uint16_t ms;
+  time_t t = m_source(ms);
+  return m_changed || (tick(t, ms) != m_tick);
+}
+
+
+unsigned long ClockZone::remaining( unsigned long now ) const
+{
+  if (due(now)) {
+    return 0;
+  }
+  uint16_t ms;
+  m_source(ms);
+  return m_period - ms % m_period;
+}
+
+
+void ClockZone::measureLateness( float &average, uint16_t &maximum )
+{
+  average = m_lateCount ? float(m_lateSum) / m_lateCount : 0;
+  maximum = m_lateMax;
+  m_lateSum = 0;
+  m_lateCount = 0;
+  m_lateMax = 0;
+}
+
+
+void ClockZone::tickPushed()
+{
+  uint16_t ms;
+  m_source(ms);
+  m_tickPending = false;
+  if (m_lateCount == 0xFFFF) {
+    return;
+  }
+
+  uint16_t late = ms % m_period;
+  m_lateSum += late;
+  m_lateCount++;
+  if (late > m_lateMax) {
+    m_lateMax = late;
+  }
+}
+
+
+int ClockZone::format( char *buf, time_t t, uint16_t millisOfSecond ) const
+{
+  if (m_seconds) {
+    return std::sprintf( buf, "%02d:%02d:%02d", hour(t), minute(t), second(t) );
+  }
+  bool delimiterVisible = !m_blink || (millisOfSecond < 500);
+  return std::sprintf( buf, delimiterVisible ? "%02d:%02d" : "%02d %02d", hour(t), minute(t) );
+}
+
+
+void ClockZone::draw( LEDMatrixDriver *driver, unsigned long now )
+{
+  uint16_t ms;
+  time_t t = m_source(ms);
+  uint32_t current = tick(t, ms);
+
+  // A boundary which has passed since the previous tick, not a redraw of the zone
+  if (!m_changed && (current != m_tick)) {
+    m_tickPending = true;
+  }
+  m_tick = current;
+
+  char buf[9];
+  int len = format(buf, t, ms);
+
+  if (strcmp(buf, m_text) == 0) {
+    return; // The same time is on the display
+  }
+  strcpy(m_text, buf);
+
+  char16_t text[8];
+  for (int idx = 0; idx < len; idx++) {
+    text[idx] = buf[idx];
+  }
+  Typeface::drawCentered(driver, m_font, text, len, m_x, m_width);
+}
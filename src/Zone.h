@@ -0,0 +1,160 @@
+#ifndef ESP_INFORMER_ZONE_H
+#define ESP_INFORMER_ZONE_H
+
+#include <vector>
+#include <string>
+#include <Arduino.h>
+#include <Time.h>
+#include "Marquee.h"
+#include "Typeface.h"
+#include "AnimatedIcon.h"
+
+class LEDMatrixDriver;
+
+/*
+ * A rectangle of the display with its own content.
+ * A zone is rasterised when its content has changed or its refresh interval has passed,
+ * and it never draws outside of its columns [x, x + width).
+ */
+class Zone
+{
+public:
+  virtual ~Zone() {}
+
+  void setRect( int x, int width );
+  int x() const { return m_x; }
+  int width() const { return m_width; }
+
+  /* Refresh interval in milliseconds, 0 - only when the content changes */
+  void setInterval( unsigned long interval ) { m_interval = interval; }
+
+  /* The whole zone is drawn again on the next render() */
+  virtual void invalidate() { m_changed = true; }
+
+  /* Animated content starts from the beginning at now */
+  virtual void restart( unsigned long now ) { invalidate(); }
+
+  /* Returns true if the zone has to be rasterised at now */
+  virtual bool due( unsigned long now ) const;
+
+  /* Milliseconds until the zone is due, or ~0 if it waits for a content change */
+  virtual unsigned long remaining( unsigned long now ) const;
+
+  void render( LEDMatrixDriver *driver, unsigned long now );
+
+protected:
+  /* Draws the content. m_changed tells if the zone has been invalidated */
+  virtual void draw( LEDMatrixDriver *driver, unsigned long now ) = 0;
+
+  int m_x = 0;
+  int m_width = 0;
+  unsigned long m_interval = 0;
+  bool m_changed = true;
+  unsigned long m_lastRender = 0;
+};
+
+
+/*
+ * An 8x8 icon, the zone is cleared if there is no icon.
+ * An animated icon advances a frame whenever the duration of its frame has passed.
+ * A greyscale icon is dithered by the driver if the zone starts at a segment boundary.
+ */
+class IconZone : public Zone
+{
+public:
+  void setIcon( const AnimatedIcon &icon );
+
+  void restart( unsigned long now ) override;
+
+protected:
+  void draw( LEDMatrixDriver *driver, unsigned long now ) override;
+
+  AnimatedIcon m_icon;
+};
+
+
+/* A text which scrolls if it does not fit the zone */
+class TextZone : public Zone
+{
+public:
+  void setText( const char16_t *text, int len, FontStyle font, unsigned long now );
+
+  void invalidate() override;
+  void restart( unsigned long now ) override;
+
+  bool scrolling() const { return m_marquee.scrolling(); }
+
+protected:
+  void draw( LEDMatrixDriver *driver, unsigned long now ) override;
+
+  Marquee m_marquee;
+};
+
+
+/*
+ * Time from a time source. Nothing is drawn while the text of the time is the same.
+ * The zone is due at the boundaries of the seconds of the source rather than after an interval,
+ * so the digits change with the source whenever the loop wakes up.
+ */
+class ClockZone : public Zone
+{
+public:
+  /* Returns the time and the milliseconds since the start of its second */
+  typedef time_t (*TimeSource)( uint16_t &millisOfSecond );
+
+  ClockZone( TimeSource source ) : m_source(source) {}
+
+  /*
+   * Without seconds the delimiter blinks if blink is true: it is shown
+   * in the first half of every second and hidden in the second one.
+   */
+  void configure( FontStyle font, bool seconds, bool blink );
+
+  FontStyle font() const { return m_font; }
+
+  /* Milliseconds between changes of the text: 500 while the delimiter blinks, otherwise 1000 */
+  uint16_t period() const { return m_period; }
+
+  /* Writes the text of the time t at millisOfSecond into buf (9 bytes). Returns its length */
+  int format( char *buf, time_t t, uint16_t millisOfSecond ) const;
+
+  void invalidate() override;
+
+  bool due( unsigned long now ) const override;
+  unsigned long remaining( unsigned long now ) const override;
+
+  /* A tick has been drawn, the frame should go to the display at once */
+  bool tickPending() const { return m_tickPending; }
+
+  /* The frame with the tick has been sent to the display, its lateness is taken now */
+  void tickPushed();
+
+  /*
+   * Milliseconds the ticks reached the display after their boundary since the previous call:
+   * the average and the maximum.
+   */
+  void measureLateness( float &average, uint16_t &maximum );
+
+protected:
+  void draw( LEDMatrixDriver *driver, unsigned long now ) override;
+
+  /* Number of the period of the time, it changes at every boundary */
+  uint32_t tick( time_t t, uint16_t millisOfSecond ) const { return t * (1000 / m_period) + millisOfSecond / m_period; }
+
+  TimeSource m_source;
+  FontStyle m_font = FontStyle::Fixed;
+  bool m_seconds = true;
+  bool m_blink = true;
+  uint16_t m_period = 1000;         // ms, 500 while the delimiter blinks
+  uint32_t m_tick = 0;              // the period on the display
+
+  /* Lateness of the ticks */
+  bool m_tickPending = false;
+  uint32_t m_lateSum = 0;
+  uint16_t m_lateCount = 0;
+  uint16_t m_lateMax = 0;
+
+  char m_text[9] = {};
+};
+
+#endif //ESP_INFORMER_ZONE_H
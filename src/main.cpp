@@ -4,6 +4,7 @@
 #include "MqttClient.h"
 #include "LEDMatrixDevice.h"
 #include "ControlButton.h"
+#include "FrameStream.h"
 
 /* Create a UI manager */
 UiManager uiManager;
@@ -14,6 +15,9 @@ DeviceMqttClient mqttClient;
 /* Device control object */
 LEDMatrixDevice *device;
 
+/* Frames received by UDP */
+FrameStream *frameStream;
+
 /* Timer to publish the current state */
 //SimpleTimer timer;
 unsigned long timer_startTime = 0;
@@ -79,6 +83,13 @@ void setup() {
     ESP.restart();
   }
 
+  /* Listen to frames by UDP */
+  frameStream = new FrameStream( device );
+#if STREAM_UDP_PORT > 0
+  frameStream->begin( STREAM_UDP_PORT );
+#endif
+  mqttClient.setFrameStream( frameStream );
+
   /* Initialize the button */
   button.init(BUTTON_PIN);
   button.onClicked( std::bind(&LEDMatrixDevice::buttonClicked, device) );
@@ -101,7 +112,13 @@ void loop() {
     timer_startTime = timer_currentTime;
   }
 
+  /* Frames of the stream go to the framebuffer before it is displayed */
+  int streamDelay = frameStream->run();
+
   int delayMillisecs = device->run();
+  if (delayMillisecs > streamDelay) {
+    delayMillisecs = streamDelay;
+  }
   button.run();
 
   delay(delayMillisecs);
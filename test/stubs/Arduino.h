@@ -0,0 +1,129 @@
+#ifndef HOST_STUB_ARDUINO_H
+#define HOST_STUB_ARDUINO_H
+
+/*
+ * Host stand-ins for the parts of the Arduino core the portable sources use.
+ * Time is simulated: it advances only by delay(), delayMicroseconds() and host::advance(),
+ * and the words sent by SPI are recorded in host::wire.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define PROGMEM
+#define ICACHE_RAM_ATTR
+#define IRAM_ATTR
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+static const uint8_t D0 = 16, D1 = 5, D2 = 4, D3 = 0, D4 = 2, D5 = 14, D6 = 12, D7 = 13, D8 = 15;
+
+/* The constants of binary.h which the sources use */
+#define B00000111 7
+#define B00011111 31
+#define B00111111 63
+#define B01011100 92
+#define B01111111 127
+#define B10000000 128
+#define B10100101 165
+#define B10100110 166
+#define B10100111 167
+#define B10101001 169
+#define B10101010 170
+#define B10101011 171
+
+#define bit(b) (1UL << (b))
+#define bitRead(value, b) (((value) >> (b)) & 0x01)
+#define bitSet(value, b) ((value) |= (1UL << (b)))
+#define bitClear(value, b) ((value) &= ~(1UL << (b)))
+#define bitWrite(value, b, x) ((x) ? bitSet(value, b) : bitClear(value, b))
+
+namespace host {
+  /* Simulated time in microseconds */
+  inline uint64_t clock = 0;
+
+  /* Words sent by SPI (high byte first). LATCH marks a rise of the select pin after data */
+  const uint16_t LATCH = 0xFFFF;
+  inline std::vector<uint16_t> wire;
+  inline bool pending = false;
+
+  /* Benchmarks turn the recording off */
+  inline bool recording = true;
+
+  inline uint8_t pins[32] = {};
+
+  inline void advance( uint64_t micros ) { clock += micros; }
+}
+
+inline unsigned long millis() { return (unsigned long)(host::clock / 1000); }
+inline unsigned long micros() { return (unsigned long)host::clock; }
+inline void delay( unsigned long ms ) { host::clock += 1000ULL * ms; }
+inline void delayMicroseconds( unsigned int us ) { host::clock += us; }
+inline void yield() {}
+
+inline void pinMode( uint8_t, uint8_t ) {}
+inline int digitalRead( uint8_t pin ) { return 0; }
+inline void digitalWrite( uint8_t pin, uint8_t value )
+{
+  // The MAX7219 chain latches on the rise of its select pin
+  if (value && !host::pins[pin & 31] && host::pending) {
+    host::wire.push_back(host::LATCH);
+    host::pending = false;
+  }
+  host::pins[pin & 31] = value;
+}
+
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+inline void *memcpy_P( void *dest, const void *src, size_t n ) { return memcpy(dest, src, n); }
+inline uint8_t pgm_read_byte( const void *p ) { return *(const uint8_t*)p; }
+inline uint16_t pgm_read_word( const void *p ) { uint16_t v; memcpy(&v, p, 2); return v; }
+inline uint32_t pgm_read_dword( const void *p ) { uint32_t v; memcpy(&v, p, 4); return v; }
+
+class String
+{
+public:
+  String( const char *s = "" ) : m_s(s) {}
+  void trim() {}
+  bool operator!=( const String &other ) const { return m_s != other.m_s; }
+  const char *c_str() const { return m_s.c_str(); }
+private:
+  std::string m_s;
+};
+
+class HardwareSerial
+{
+public:
+  void begin( unsigned long ) {}
+  template<class... A> void printf( const char *, A... ) {}
+  template<class T> void print( T ) {}
+  template<class T> void println( T ) {}
+  void println() {}
+};
+inline HardwareSerial Serial;
+
+class EspClass
+{
+public:
+  uint32_t getFreeHeap() { return 0; }
+  uint32_t getMaxFreeBlockSize() { return 0; }
+  uint8_t getHeapFragmentation() { return 0; }
+  void restart() {}
+};
+inline EspClass ESP;
+
+#endif //HOST_STUB_ARDUINO_H
@@ -0,0 +1,26 @@
+#ifndef HOST_STUB_FS_H
+#define HOST_STUB_FS_H
+
+#include <Arduino.h>
+
+/* A file system without files */
+class File
+{
+public:
+  operator bool() const { return false; }
+  bool seek( uint32_t ) { return false; }
+  size_t read( uint8_t *, size_t ) { return 0; }
+  size_t size() { return 0; }
+  void close() {}
+};
+
+class FS
+{
+public:
+  bool begin() { return true; }
+  File open( const char *, const char * ) { return File(); }
+  bool exists( const char * ) { return false; }
+};
+inline FS SPIFFS;
+
+#endif //HOST_STUB_FS_H
@@ -0,0 +1,43 @@
+#ifndef HOST_MAX7219_CHAIN_H
+#define HOST_MAX7219_CHAIN_H
+
+#include <Arduino.h>
+
+/*
+ * Registers of a chain of MAX7219 fed from host::wire.
+ * At every latch the last word sent is in the first chip of the chain, the one before in the second and so on.
+ */
+class MAX7219Chain
+{
+public:
+  MAX7219Chain( uint8_t chips ) : m_chips(chips), m_registers(16 * chips, 0) {}
+
+  /* Applies and clears the recorded words */
+  void apply()
+  {
+    std::vector<uint16_t> words;
+    for (uint16_t word : host::wire) {
+      if (word != host::LATCH) {
+        words.push_back(word);
+        continue;
+      }
+      for (size_t chip = 0; chip < m_chips && chip < words.size(); chip++) {
+        uint16_t command = words[words.size() - 1 - chip];
+        if (command >> 8) {
+          m_registers[16 * chip + (command >> 8)] = command & 0xFF;
+        }
+      }
+      words.clear();
+    }
+    host::wire.clear();
+  }
+
+  uint8_t reg( uint8_t chip, uint8_t address ) const { return m_registers[16 * chip + address]; }
+  bool operator==( const MAX7219Chain &other ) const { return m_registers == other.m_registers; }
+
+private:
+  size_t m_chips;
+  std::vector<uint8_t> m_registers;
+};
+
+#endif //HOST_MAX7219_CHAIN_H
@@ -0,0 +1,48 @@
+#ifndef HOST_STUB_SPI_H
+#define HOST_STUB_SPI_H
+
+#include <Arduino.h>
+
+#define SPI_MODE0 0
+
+class SPISettings
+{
+public:
+  SPISettings( uint32_t = 0, uint8_t = 0, uint8_t = 0 ) {}
+};
+
+/* Records the bytes as 16-bit words in host::wire and counts the transactions */
+class SPIClass
+{
+public:
+  void begin() {}
+  void beginTransaction( SPISettings ) { transactions++; }
+  void endTransaction() {}
+
+  uint8_t transfer( uint8_t data ) { push(data); return 0; }
+  uint16_t transfer16( uint16_t data ) { push(data >> 8); push(data & 0xFF); return 0; }
+  void writeBytes( const uint8_t *data, uint32_t size ) { for (uint32_t i = 0; i < size; i++) push(data[i]); }
+
+  unsigned transactions = 0;
+
+private:
+  void push( uint8_t data )
+  {
+    if (!host::recording) {
+      return;
+    }
+    if (m_half) {
+      host::wire.push_back((m_high << 8) | data);
+      host::pending = true;
+    } else {
+      m_high = data;
+    }
+    m_half = !m_half;
+  }
+
+  bool m_half = false;
+  uint8_t m_high = 0;
+};
+inline SPIClass SPI;
+
+#endif //HOST_STUB_SPI_H
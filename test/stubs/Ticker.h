@@ -0,0 +1,32 @@
+#ifndef HOST_STUB_TICKER_H
+#define HOST_STUB_TICKER_H
+
+#include <functional>
+#include <cstdint>
+
+/* A timer which fires only when the test calls fire() */
+class Ticker
+{
+public:
+  template<class T> void attach_ms( uint32_t interval, void (*callback)(T), T arg )
+  {
+    m_interval = interval;
+    m_callback = [callback, arg]() { callback(arg); };
+  }
+  void attach_ms( uint32_t interval, void (*callback)() )
+  {
+    m_interval = interval;
+    m_callback = callback;
+  }
+  void detach() { m_callback = nullptr; }
+  bool active() const { return (bool)m_callback; }
+
+  uint32_t interval() const { return m_interval; }
+  void fire() { if (m_callback) m_callback(); }
+
+private:
+  uint32_t m_interval = 0;
+  std::function<void()> m_callback;
+};
+
+#endif //HOST_STUB_TICKER_H
@@ -0,0 +1,57 @@
+#ifndef HOST_STUB_TIME_H
+#define HOST_STUB_TIME_H
+
+#include <ctime>
+#include <cstdint>
+
+/* The subset of the Time library the sources use */
+typedef struct {
+  uint8_t Second;
+  uint8_t Minute;
+  uint8_t Hour;
+  uint8_t Wday;   // day of week, sunday is day 1
+  uint8_t Day;
+  uint8_t Month;
+  uint8_t Year;   // offset from 1970
+} tmElements_t;
+
+#define tmYearToCalendar(Y) ((Y) + 1970)
+#define CalendarYrToTm(Y) ((Y) - 1970)
+#define tmYearToY2k(Y) ((Y) - 30)
+#define y2kYearToTm(Y) ((Y) + 30)
+
+inline int hour( time_t t ) { return (t / 3600) % 24; }
+inline int minute( time_t t ) { return (t / 60) % 60; }
+inline int second( time_t t ) { return t % 60; }
+
+inline time_t makeTime( const tmElements_t &tm )
+{
+  // Days from the civil date, 1 March based
+  int y = tmYearToCalendar(tm.Year) - (tm.Month <= 2);
+  int era = y / 400;
+  int yoe = y - era * 400;
+  int doy = (153 * (tm.Month + (tm.Month > 2 ? -3 : 9)) + 2) / 5 + tm.Day - 1;
+  int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  long days = era * 146097L + doe - 719468;
+  return days * 86400 + tm.Hour * 3600 + tm.Minute * 60 + tm.Second;
+}
+
+inline void breakTime( time_t t, tmElements_t &tm )
+{
+  tm.Second = t % 60;
+  tm.Minute = (t / 60) % 60;
+  tm.Hour = (t / 3600) % 24;
+  long days = t / 86400;
+  tm.Wday = ((days + 4) % 7) + 1;
+  days += 719468;
+  long era = days / 146097;
+  long doe = days - era * 146097;
+  long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  long mp = (5 * doy + 2) / 153;
+  tm.Day = doy - (153 * mp + 2) / 5 + 1;
+  tm.Month = mp < 10 ? mp + 3 : mp - 9;
+  tm.Year = CalendarYrToTm(yoe + era * 400 + (tm.Month <= 2));
+}
+
+#endif //HOST_STUB_TIME_H
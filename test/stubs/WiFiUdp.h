@@ -0,0 +1,43 @@
+#ifndef HOST_STUB_WIFI_UDP_H
+#define HOST_STUB_WIFI_UDP_H
+
+#include <Arduino.h>
+#include <deque>
+
+namespace host {
+  /* Datagrams waiting in the socket, the oldest first */
+  inline std::deque<std::vector<uint8_t>> udp;
+}
+
+/* Receives the datagrams the test has put into host::udp */
+class WiFiUDP
+{
+public:
+  uint8_t begin( uint16_t port ) { return 1; }
+
+  int parsePacket()
+  {
+    m_packet.clear();
+    m_position = 0;
+    if (host::udp.empty()) {
+      return 0;
+    }
+    m_packet = host::udp.front();
+    host::udp.pop_front();
+    return m_packet.size();
+  }
+
+  int read( uint8_t *buffer, size_t len )
+  {
+    size_t count = std::min(len, m_packet.size() - m_position);
+    memcpy(buffer, m_packet.data() + m_position, count);
+    m_position += count;
+    return count;
+  }
+
+private:
+  std::vector<uint8_t> m_packet;
+  size_t m_position = 0;
+};
+
+#endif //HOST_STUB_WIFI_UDP_H
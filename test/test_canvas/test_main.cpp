@@ -0,0 +1,142 @@
+/*
+ * The canvas over several chains: pixels map to the band of the right chain,
+ * frames go out interleaved, and the benchmark times a frame against the number of modules.
+ */
+
+#include <unity.h>
+#include <chrono>
+#include <MAX7219Chain.h>
+#include "LEDMatrixCanvas.h"
+
+static const uint16_t WIDTH = 64;
+static const uint8_t PINS[LEDMatrixCanvas::MAX_CHAINS] = { 15, 4, 5, 16 };
+
+void setUp() { host::wire.clear(); host::recording = true; }
+void tearDown() {}
+
+// Every pixel of the canvas lands in the band of its chain
+void test_pixels_map_to_chains()
+{
+  LEDMatrixCanvas canvas(WIDTH);
+  TEST_ASSERT_TRUE(canvas.addChain(PINS[0], 2));
+  TEST_ASSERT_TRUE(canvas.addChain(PINS[1], 1));
+  TEST_ASSERT_EQUAL(24, canvas.height());
+
+  for (int y = 0; y < canvas.height(); y++) {
+    for (int x = 0; x < WIDTH; x++) {
+      canvas.setPixel(x, y, (x * 7 + y * 3) % 5 == 0);
+    }
+  }
+
+  for (int y = 0; y < canvas.height(); y++) {
+    // Bands 0 and 1 are the first chain side by side, band 2 is the second chain
+    LEDMatrixDriver *driver = canvas.chain(y < 16 ? 0 : 1);
+    int offset = y < 16 ? (y >> 3) * WIDTH : 0;
+    for (int x = 0; x < WIDTH; x++) {
+      bool expected = (x * 7 + y * 3) % 5 == 0;
+      TEST_ASSERT_EQUAL(expected, canvas.getPixel(x, y));
+      TEST_ASSERT_EQUAL(expected, driver->getPixel(offset + x, y & 7));
+    }
+  }
+}
+
+// One transaction, a row of every chain before the next row
+void test_interleaved_frame()
+{
+  LEDMatrixCanvas canvas(WIDTH);
+  canvas.addChain(PINS[0], 2);
+  canvas.addChain(PINS[1], 1);
+  canvas.setPixel(3, 20, true);
+  canvas.display();
+
+  host::wire.clear();
+  unsigned transactions = SPI.transactions;
+  canvas.invalidate();
+  canvas.display();
+
+  // 16 + 1 words of the first chain and 8 + 1 of the second for every row
+  TEST_ASSERT_EQUAL(1, SPI.transactions - transactions);
+  TEST_ASSERT_EQUAL(8 * (16 + 1 + 8 + 1), host::wire.size());
+  for (int y = 0; y < 8; y++) {
+    TEST_ASSERT_EQUAL_HEX16(host::LATCH, host::wire[y * 26 + 16]);
+    TEST_ASSERT_EQUAL_HEX16(host::LATCH, host::wire[y * 26 + 25]);
+  }
+}
+
+// 2048 pixels are 256 segments per band, more than a chain can take
+void test_limits()
+{
+  LEDMatrixCanvas wide(2048);
+  TEST_ASSERT_FALSE(wide.addChain(PINS[0], 1));
+
+  LEDMatrixCanvas tall(WIDTH);
+  TEST_ASSERT_TRUE(tall.addChain(PINS[0], LEDMatrixCanvas::MAX_BANDS / 2));
+  TEST_ASSERT_FALSE(tall.addChain(PINS[1], LEDMatrixCanvas::MAX_BANDS / 2 + 1));
+  TEST_ASSERT_TRUE(tall.addChain(PINS[1], LEDMatrixCanvas::MAX_BANDS / 2));
+  TEST_ASSERT_EQUAL(8 * LEDMatrixCanvas::MAX_BANDS, tall.height());
+}
+
+// Nanoseconds to draw every pixel and to push a full frame, the best of 5 runs
+static void benchmark( uint8_t chains, uint8_t bands, double &draw, double &push, size_t &words )
+{
+  const int FRAMES = 2000;
+  LEDMatrixCanvas canvas(WIDTH);
+  for (uint8_t i = 0; i < chains; i++) {
+    canvas.addChain(PINS[i], bands);
+  }
+
+  host::wire.clear();
+  canvas.invalidate();
+  canvas.display();
+  words = host::wire.size() - std::count(host::wire.begin(), host::wire.end(), host::LATCH);
+
+  host::recording = false;
+  for (int run = 0; run < 5; run++) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < FRAMES; i++) {
+      for (int y = 0; y < canvas.height(); y++) {
+        for (int x = 0; x < WIDTH; x++) {
+          canvas.setPixel(x, y, (x + y + i) & 1);
+        }
+      }
+    }
+    auto middle = std::chrono::steady_clock::now();
+    for (int i = 0; i < FRAMES; i++) {
+      canvas.invalidate();
+      canvas.display();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double d = std::chrono::duration<double, std::nano>(middle - start).count() / FRAMES;
+    double p = std::chrono::duration<double, std::nano>(end - middle).count() / FRAMES;
+    draw = (run == 0 || d < draw) ? d : draw;
+    push = (run == 0 || p < push) ? p : push;
+  }
+  host::recording = true;
+}
+
+void test_benchmark_modules()
+{
+  // 8 modules per band: one chain, then up to MAX_CHAINS chains, then longer chains
+  const uint8_t layouts[][2] = { { 1, 1 }, { 2, 1 }, { 4, 1 }, { 4, 2 } };
+  for (auto &layout : layouts) {
+    double draw, push;
+    size_t words;
+    benchmark(layout[0], layout[1], draw, push, words);
+
+    char message[160];
+    snprintf(message, sizeof(message), "%2d modules on %d chain(s): draw %.0f ns, push %.0f ns, %u words, %.1f us on the bus",
+             layout[0] * layout[1] * WIDTH / 8, layout[0], draw, push, (unsigned)words, words * 16 / 10.0);
+    TEST_MESSAGE(message);
+  }
+}
+
+int main( int argc, char **argv )
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_pixels_map_to_chains);
+  RUN_TEST(test_interleaved_frame);
+  RUN_TEST(test_limits);
+  RUN_TEST(test_benchmark_modules);
+  return UNITY_END();
+}
@@ -0,0 +1,89 @@
+/*
+ * The soft clock with the RTC of the host stubs, which never starts a new second:
+ * the syncs fail, and the clock must neither block the loop nor poll the RTC all the time.
+ * The clock of the device goes to the display at its second boundaries.
+ */
+
+#include <unity.h>
+#include <SPI.h>
+#include <Ticker.h>
+#include "SoftClock.h"
+#include "LEDMatrixDevice.h"
+
+static const unsigned long SYNC_INTERVAL = 3600000;
+
+void setUp() {}
+void tearDown() {}
+
+// Runs the clock for ms milliseconds the way loop() does, returns the longest run() in ms
+static unsigned long runFor( unsigned long ms )
+{
+  unsigned long longest = 0;
+  unsigned long end = millis() + ms;
+  while (millis() < end) {
+    unsigned long start = millis();
+    SoftClock::run();
+    longest = std::max(longest, millis() - start);
+    unsigned long wait = SoftClock::untilSync();
+    delay(wait > 0 ? (wait < 100 ? wait : 100) : 1);
+  }
+  return longest;
+}
+
+// A halted RTC is retried a few times, then after the sync interval, and no run() waits longer than the sync window
+void test_halted_rtc_backs_off()
+{
+  SoftClock::begin(SYNC_INTERVAL);
+  TEST_ASSERT_EQUAL(0, SoftClock::syncs());
+  TEST_ASSERT_TRUE(SoftClock::untilSync() > 0);
+
+  unsigned long longest = runFor(30000);
+  TEST_ASSERT_TRUE(longest <= SoftClock::SYNC_WINDOW);
+
+  // The retries are over
+  uint32_t reads = SoftClock::rtcReads();
+  TEST_ASSERT_TRUE(SoftClock::untilSync() > SYNC_INTERVAL - 30000);
+  runFor(600000);
+  TEST_ASSERT_EQUAL(reads, SoftClock::rtcReads());
+
+  // The next attempt comes with the sync interval
+  longest = runFor(SYNC_INTERVAL);
+  TEST_ASSERT_TRUE(longest <= SoftClock::SYNC_WINDOW);
+  TEST_ASSERT_TRUE(SoftClock::rtcReads() > reads);
+  TEST_ASSERT_EQUAL(0, SoftClock::syncs());
+
+  char message[96];
+  snprintf(message, sizeof(message), "longest run(): %lu ms, RTC reads in %lu s: %u",
+           longest, (millis() / 1000), SoftClock::rtcReads());
+  TEST_MESSAGE(message);
+}
+
+// A tick is sent when it is drawn, the refresh timer of the driver (never fired here) does not hold it back
+void test_tick_is_pushed_at_the_boundary()
+{
+  LEDMatrixDevice device;
+  float average;
+  uint16_t maximum;
+  device.run();
+  device.measureClockJitter(average, maximum);
+
+  // The loop wakes up at the next boundary, the new digits are sent there
+  for (int i = 0; i < 5; i++) {
+    uint16_t ms;
+    SoftClock::now(ms);
+    delay(1000 - ms);
+    host::wire.clear();
+    device.run();
+    TEST_ASSERT_TRUE(host::wire.size() > 0);
+  }
+  device.measureClockJitter(average, maximum);
+  TEST_ASSERT_EQUAL(0, maximum);
+}
+
+int main( int argc, char **argv )
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_halted_rtc_backs_off);
+  RUN_TEST(test_tick_is_pushed_at_the_boundary);
+  return UNITY_END();
+}
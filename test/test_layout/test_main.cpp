@@ -0,0 +1,103 @@
+/*
+ * The wire-order framebuffer layout against the logical one:
+ * the same drawing must put the same values into the MAX7219 registers for every orientation,
+ * and the benchmark compares the time of a full-frame push.
+ */
+
+#include <unity.h>
+#include <chrono>
+#include <MAX7219Chain.h>
+#include "LEDMatrixDriver.h"
+
+static const uint8_t SEGMENTS = 8;
+static const uint8_t SS_PIN = 15;
+static const uint8_t ORIENTATION = LEDMatrixDriver::INVERT_DISPLAY_X | LEDMatrixDriver::INVERT_SEGMENT_X | LEDMatrixDriver::INVERT_Y;
+
+static const uint8_t SPRITE[8] = { 0x3C, 0x42, 0xA5, 0x81, 0xA5, 0x99, 0x42, 0x3C };
+
+void setUp() { host::wire.clear(); host::recording = true; }
+void tearDown() {}
+
+// Pixels, sprites at unaligned positions and a scroll
+static void draw( LEDMatrixDriver &driver )
+{
+  for (int x = 0; x < 8 * SEGMENTS; x += 3) {
+    driver.setPixel(x, x % 8, true);
+  }
+  driver.drawSprite(SPRITE, 5, 0, 8, 8);
+  driver.drawSprite(SPRITE, 29, 1, 8, 7);
+  driver.scroll(LEDMatrixDriver::ScrollDirection::Left, 3);
+  driver.setColumn(60, 0xA5);
+}
+
+// The registers after a full-frame push
+static MAX7219Chain fullFrame( LEDMatrixDriver &driver )
+{
+  MAX7219Chain chain(SEGMENTS);
+  host::wire.clear();
+  driver.invalidate();
+  driver.display();
+  TEST_ASSERT_EQUAL(8 * (SEGMENTS + 1), host::wire.size());
+  chain.apply();
+  return chain;
+}
+
+void test_same_display_for_all_orientations()
+{
+  for (uint8_t flags = 0; flags < 8; flags++) {
+    LEDMatrixDriver logical(SEGMENTS, SS_PIN, flags);
+    LEDMatrixDriver wire(SEGMENTS, SS_PIN, flags | LEDMatrixDriver::WIRE_ORDER);
+    draw(logical);
+    draw(wire);
+
+    // Rows may go out in another order, the display ends up the same
+    TEST_ASSERT_TRUE(fullFrame(logical) == fullFrame(wire));
+
+    for (int y = 0; y < 8; y++) {
+      for (int x = 0; x < 8 * SEGMENTS; x++) {
+        TEST_ASSERT_EQUAL(logical.getPixel(x, y), wire.getPixel(x, y));
+      }
+    }
+  }
+}
+
+// Nanoseconds per full-frame push, the best of 5 runs. The SPI transfers themselves are not recorded.
+static double benchmark( uint8_t flags )
+{
+  const int FRAMES = 20000;
+  LEDMatrixDriver driver(SEGMENTS, SS_PIN, flags);
+  draw(driver);
+
+  host::recording = false;
+  double best = 0;
+  for (int run = 0; run < 5; run++) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < FRAMES; i++) {
+      driver.invalidate();
+      driver.display();
+    }
+    double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / FRAMES;
+    best = (run == 0 || elapsed < best) ? elapsed : best;
+  }
+  host::recording = true;
+  return best;
+}
+
+void test_benchmark_full_frame_push()
+{
+  double logical = benchmark(ORIENTATION);
+  double wire = benchmark(ORIENTATION | LEDMatrixDriver::WIRE_ORDER);
+
+  char message[128];
+  snprintf(message, sizeof(message), "full-frame push of %d segments: logical %.0f ns, wire order %.0f ns (%.2fx)",
+           SEGMENTS, logical, wire, logical / wire);
+  TEST_MESSAGE(message);
+}
+
+int main( int argc, char **argv )
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_same_display_for_all_orientations);
+  RUN_TEST(test_benchmark_full_frame_push);
+  return UNITY_END();
+}
@@ -0,0 +1,112 @@
+/*
+ * Notifications of the device: their timers, raw frames which interrupt them and the order of the queue.
+ * Screens beyond the capacity are rejected and counted.
+ */
+
+#include <unity.h>
+#include <SPI.h>
+#include <Ticker.h>
+#include <string>
+#include <vector>
+
+// The tests check the display state of the device
+#define private public
+#include "LEDMatrixDevice.h"
+#undef private
+
+static LEDMatrixDevice *device = nullptr;
+static AnimatedIcon noIcon;
+
+void setUp() { device = new LEDMatrixDevice(); host::wire.clear(); }
+void tearDown() { delete device; device = nullptr; }
+
+// Runs the device for ms milliseconds the way loop() does
+static void runFor( unsigned long ms )
+{
+  unsigned long end = millis() + ms;
+  while (millis() < end) {
+    int wait = device->run();
+    delay(wait > 0 ? (wait < 100 ? wait : 100) : 1);
+  }
+}
+
+static void writeFrame( uint16_t holdSeconds )
+{
+  std::vector<uint8_t> frame(LEDMatrixDevice::FRAME_SIZE + 2, 0xAA);
+  frame[LEDMatrixDevice::FRAME_SIZE] = holdSeconds >> 8;
+  frame[LEDMatrixDevice::FRAME_SIZE + 1] = holdSeconds & 0xFF;
+  device->writeFrame(frame.data(), 0, frame.size(), frame.size());
+}
+
+// The timer of a notification does not run while a frame is shown, and starts again when it comes back
+void test_frame_pauses_the_notification_timer()
+{
+  device->setNotification(noIcon, "first", 5);
+  runFor(1000);
+  TEST_ASSERT_TRUE(device->m_displayState == LEDMatrixDevice::DisplayState::Notification);
+
+  writeFrame(10);
+  runFor(8000);
+  TEST_ASSERT_TRUE(device->m_displayState == LEDMatrixDevice::DisplayState::Frame);
+  TEST_ASSERT_EQUAL(1, device->queuedNotifications());
+
+  // The frame is held for 10 s, then the notification gets its whole 5 s
+  runFor(2500);
+  TEST_ASSERT_TRUE(device->m_displayState == LEDMatrixDevice::DisplayState::Notification);
+  runFor(4000);
+  TEST_ASSERT_EQUAL(1, device->queuedNotifications());
+  runFor(1500);
+  TEST_ASSERT_EQUAL(0, device->queuedNotifications());
+  TEST_ASSERT_TRUE(device->m_displayState == LEDMatrixDevice::DisplayState::Time);
+}
+
+// A preempting notification puts a queued one of a higher priority in front of itself, that one is displayed
+void test_preempt_shows_a_higher_queued_notification()
+{
+  NotificationOptions options;
+  device->setNotification(noIcon, "A", 5);
+  runFor(1000);
+
+  options.priority = 10;
+  device->setNotification(noIcon, "B", 20, FontStyle::Fixed, options);
+  runFor(1000);
+  TEST_ASSERT_EQUAL(u'A', device->m_notificationQueue.front().text[0]);
+
+  options.priority = 5;
+  options.preempt = true;
+  device->setNotification(noIcon, "C", 20, FontStyle::Fixed, options);
+  TEST_ASSERT_EQUAL(u'B', device->m_notificationQueue.front().text[0]);
+  TEST_ASSERT_EQUAL(20000, device->m_notificationTimerTimeoutMilliseconds);
+
+  // The timer of A does not run out on B
+  runFor(5000);
+  TEST_ASSERT_TRUE(device->m_displayState == LEDMatrixDevice::DisplayState::Notification);
+  TEST_ASSERT_EQUAL(u'B', device->m_notificationQueue.front().text[0]);
+  TEST_ASSERT_EQUAL(3, device->queuedNotifications());
+}
+
+void test_screens_beyond_capacity_are_rejected()
+{
+  for (int id = 0; id < SCREEN_CAPACITY; id++) {
+    device->setScreen(id, noIcon, "screen", FontStyle::Fixed);
+  }
+  TEST_ASSERT_EQUAL(SCREEN_CAPACITY, device->screenCount());
+  TEST_ASSERT_EQUAL(0, device->rejectedScreens());
+
+  // Updates of the screens still fit, a new id does not
+  device->setScreen(0, noIcon, "update", FontStyle::Fixed);
+  device->setScreen(SCREEN_CAPACITY, noIcon, "new", FontStyle::Fixed);
+  TEST_ASSERT_EQUAL(SCREEN_CAPACITY, device->screenCount());
+  TEST_ASSERT_EQUAL(1, device->rejectedScreens());
+  TEST_ASSERT_EQUAL(ScreenTable::NO_POSITION, device->m_screens.position(SCREEN_CAPACITY));
+  TEST_ASSERT_EQUAL('u', device->m_screens.at(0).text[0]);
+}
+
+int main( int argc, char **argv )
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_frame_pauses_the_notification_timer);
+  RUN_TEST(test_preempt_shows_a_higher_queued_notification);
+  RUN_TEST(test_screens_beyond_capacity_are_rejected);
+  return UNITY_END();
+}
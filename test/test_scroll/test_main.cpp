@@ -0,0 +1,138 @@
+/*
+ * The scroll kernels against the byte-wise carry loop of scrollReference():
+ * scroll(direction, n) must leave the same pixels and the same changed segments as n reference steps
+ * for every layout, and the benchmark compares the time of a call.
+ */
+
+#include <unity.h>
+#include <SPI.h>
+#include <Ticker.h>
+#include <chrono>
+#include <cstring>
+
+// The tests compare the changed segments of the drivers
+#define private public
+#define protected public
+#include "LEDMatrixDriver.h"
+#undef protected
+#undef private
+
+static const uint8_t SS_PIN = 15;
+static const uint8_t ORIENTATION = LEDMatrixDriver::INVERT_DISPLAY_X | LEDMatrixDriver::INVERT_SEGMENT_X | LEDMatrixDriver::INVERT_Y;
+
+static const LEDMatrixDriver::ScrollDirection DIRECTIONS[] = {
+  LEDMatrixDriver::ScrollDirection::Left, LEDMatrixDriver::ScrollDirection::Right,
+  LEDMatrixDriver::ScrollDirection::Up, LEDMatrixDriver::ScrollDirection::Down
+};
+
+void setUp() { host::wire.clear(); host::recording = false; }
+void tearDown() { host::recording = true; }
+
+static void draw( LEDMatrixDriver &driver, uint8_t segments )
+{
+  for (int x = 0; x < 8 * segments; x++) {
+    driver.setPixel(x, (x * 5) % 8, true);
+    driver.setPixel(x, (x * 3 + 1) % 8, x & 1);
+  }
+  // Everything drawn so far counts as sent
+  driver.display();
+}
+
+// The same pixels. The same changed segments after one step; after several the reference also
+// marks the bytes which have changed and changed back, so the kernel marks a part of them.
+static void compare( LEDMatrixDriver &kernel, LEDMatrixDriver &reference, uint8_t segments, uint8_t steps, const char *message )
+{
+  for (int y = 0; y < 8; y++) {
+    for (int x = 0; x < 8 * segments; x++) {
+      TEST_ASSERT_EQUAL_MESSAGE(reference.getPixel(x, y), kernel.getPixel(x, y), message);
+    }
+  }
+  if (steps == 1) {
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(reference.m_dirtyRows, kernel.m_dirtyRows, message);
+    TEST_ASSERT_EQUAL_MEMORY_MESSAGE(reference.m_dirtySegments, kernel.m_dirtySegments, 8 * kernel.m_dirtyStride, message);
+  }
+  for (int i = 0; i < 8 * kernel.m_dirtyStride; i++) {
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(0, kernel.m_dirtySegments[i] & ~reference.m_dirtySegments[i], message);
+  }
+}
+
+// Every layout, every direction and shifts of 1 - 9 pixels on chains of 1, 4 and 8 segments
+void test_kernels_match_reference()
+{
+  const uint8_t chains[] = { 1, 4, 8 };
+  const uint8_t layouts[] = { 0, ORIENTATION, LEDMatrixDriver::WIRE_ORDER, ORIENTATION | LEDMatrixDriver::WIRE_ORDER,
+                              LEDMatrixDriver::INVERT_SEGMENT_X | LEDMatrixDriver::WIRE_ORDER,
+                              LEDMatrixDriver::INVERT_DISPLAY_X | LEDMatrixDriver::WIRE_ORDER };
+  for (uint8_t segments : chains) {
+    for (uint8_t flags : layouts) {
+      for (int d = 0; d < 4; d++) {
+        for (uint8_t n = 1; n <= 9; n++) {
+          LEDMatrixDriver kernel(segments, SS_PIN, flags);
+          LEDMatrixDriver reference(segments, SS_PIN, flags);
+          draw(kernel, segments);
+          draw(reference, segments);
+
+          kernel.scroll(DIRECTIONS[d], n);
+          for (uint8_t i = 0; i < n; i++) {
+            reference.scrollReference(DIRECTIONS[d]);
+          }
+
+          char message[64];
+          snprintf(message, sizeof(message), "%d segments, flags %d, direction %d, %d px", segments, flags, d, n);
+          compare(kernel, reference, segments, n, message);
+        }
+      }
+    }
+  }
+}
+
+// Nanoseconds per call, the best of 5 runs
+template<typename Scroll>
+static double benchmark( LEDMatrixDriver &driver, uint8_t segments, Scroll scroll )
+{
+  const int CALLS = 20000;
+  double best = 0;
+  for (int run = 0; run < 5; run++) {
+    draw(driver, segments);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < CALLS; i++) {
+      scroll();
+      // The pixels scrolled out come back, so the rows never run empty
+      driver.setPixel(i % (8 * segments), i % 8, true);
+    }
+    double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / CALLS;
+    best = (run == 0 || elapsed < best) ? elapsed : best;
+  }
+  return best;
+}
+
+void test_benchmark_scroll()
+{
+  const uint8_t segments = 8;
+  const char *names[] = { "left", "right", "up", "down" };
+  for (uint8_t layout = 0; layout < 2; layout++) {
+    uint8_t flags = ORIENTATION | (layout ? LEDMatrixDriver::WIRE_ORDER : 0);
+    LEDMatrixDriver driver(segments, SS_PIN, flags);
+    for (int d = 0; d < 4; d++) {
+      LEDMatrixDriver::ScrollDirection direction = DIRECTIONS[d];
+      double reference = benchmark(driver, segments, [&]() { driver.scrollReference(direction); });
+      double kernel = benchmark(driver, segments, [&]() { driver.scroll(direction, 1); });
+      double reference4 = benchmark(driver, segments, [&]() { for (int i = 0; i < 4; i++) driver.scrollReference(direction); });
+      double kernel4 = benchmark(driver, segments, [&]() { driver.scroll(direction, 4); });
+
+      char message[160];
+      snprintf(message, sizeof(message), "%s, %s, %d segments: 1 px %.0f ns vs reference %.0f ns (%.2fx), 4 px %.0f ns vs %.0f ns (%.2fx)",
+               layout ? "wire order" : "logical", names[d], segments,
+               kernel, reference, reference / kernel, kernel4, reference4, reference4 / kernel4);
+      TEST_MESSAGE(message);
+    }
+  }
+}
+
+int main( int argc, char **argv )
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_kernels_match_reference);
+  RUN_TEST(test_benchmark_scroll);
+  return UNITY_END();
+}
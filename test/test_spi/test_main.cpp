@@ -0,0 +1,264 @@
+/*
+ * The words the driver sends to the MAX7219 chain, recorded by the SPI stub.
+ * The reference is the stream of the original displayRow(): for every row a select,
+ * one address/data word per segment and a latch.
+ */
+
+#include <unity.h>
+#include <SPI.h>
+#include <Ticker.h>
+#include <cstring>
+
+// The tests fire the refresh timer of the driver
+#define private public
+#include "LEDMatrixDriver.h"
+#undef private
+
+static const uint8_t SEGMENTS = 8;
+static const uint8_t SS_PIN = 15;
+static const uint8_t ORIENTATION = LEDMatrixDriver::INVERT_DISPLAY_X | LEDMatrixDriver::INVERT_SEGMENT_X | LEDMatrixDriver::INVERT_Y;
+
+void setUp() { host::wire.clear(); }
+void tearDown() {}
+
+static void draw( LEDMatrixDriver &driver )
+{
+  for (int x = 0; x < 8 * SEGMENTS; x++) {
+    driver.setPixel(x, (x * 5) % 8, true);
+    driver.setPixel(x, (x * 3) % 8, x & 1);
+  }
+}
+
+// The logical byte of 8 pixels, MSB is the leftmost pixel
+static uint8_t logicalByte( const LEDMatrixDriver &driver, uint8_t y, uint8_t column )
+{
+  uint8_t value = 0;
+  for (int i = 0; i < 8; i++) {
+    value = (value << 1) | driver.getPixel(8 * column + i, y);
+  }
+  return value;
+}
+
+// The stream of the original transfer16 path for the logical rows in mask
+static std::vector<uint16_t> baseline( const LEDMatrixDriver &driver, uint8_t flags, uint8_t mask = 0xFF )
+{
+  std::vector<uint16_t> words;
+  for (uint8_t y = 0; y < 8; y++) {
+    if (!(mask & (1 << y))) {
+      continue;
+    }
+    // The buffer row of the old layout is the logical row, the address carries INVERT_Y
+    uint8_t address = (flags & LEDMatrixDriver::INVERT_Y ? 7 - y : y) + 1;
+    for (uint8_t i = 0; i < SEGMENTS; i++) {
+      uint8_t column = flags & LEDMatrixDriver::INVERT_DISPLAY_X ? SEGMENTS - 1 - i : i;
+      uint8_t data = logicalByte(driver, y, column);
+      if (flags & LEDMatrixDriver::INVERT_SEGMENT_X) {
+        data = LEDMatrixDriver::reverseByte(data);
+      }
+      words.push_back((address << 8) | data);
+    }
+    words.push_back(host::LATCH);
+  }
+  return words;
+}
+
+void test_full_frame_matches_baseline()
+{
+  for (uint8_t flags = 0; flags < 8; flags++) {
+    LEDMatrixDriver driver(SEGMENTS, SS_PIN, flags);
+    draw(driver);
+    host::wire.clear();
+
+    unsigned transactions = SPI.transactions;
+    driver.invalidate();
+    driver.display();
+
+    TEST_ASSERT_TRUE(host::wire == baseline(driver, flags));
+    TEST_ASSERT_EQUAL(1, SPI.transactions - transactions);
+  }
+}
+
+void test_idle_display_sends_nothing()
+{
+  LEDMatrixDriver driver(SEGMENTS, SS_PIN, ORIENTATION | LEDMatrixDriver::WIRE_ORDER);
+  draw(driver);
+  driver.display();
+  host::wire.clear();
+
+  unsigned transactions = SPI.transactions;
+  driver.display();
+  driver.setPixel(3, 3, driver.getPixel(3, 3));   // no change
+  driver.display();
+
+  TEST_ASSERT_EQUAL(0, host::wire.size());
+  TEST_ASSERT_EQUAL(transactions, SPI.transactions);
+}
+
+// A changed pixel sends its row only, the other segments of the row get no-op words
+void test_dirty_row_with_noop_words()
+{
+  for (uint8_t layout = 0; layout < 2; layout++) {
+    uint8_t flags = ORIENTATION | (layout ? LEDMatrixDriver::WIRE_ORDER : 0);
+    LEDMatrixDriver driver(SEGMENTS, SS_PIN, flags);
+    draw(driver);
+    driver.display();
+    host::wire.clear();
+
+    // Logical segment 2 of logical row 5
+    driver.setPixel(17, 5, !driver.getPixel(17, 5));
+    driver.display();
+
+    // The chain position of the segment and the address of the row follow the orientation
+    uint8_t position = SEGMENTS - 1 - 2;
+    uint16_t word = ((7 - 5 + 1) << 8) | LEDMatrixDriver::reverseByte(logicalByte(driver, 5, 2));
+    TEST_ASSERT_EQUAL(SEGMENTS + 1, host::wire.size());
+    for (uint8_t i = 0; i < SEGMENTS; i++) {
+      TEST_ASSERT_EQUAL_HEX16(i == position ? word : 0x0000, host::wire[i]);
+    }
+    TEST_ASSERT_EQUAL_HEX16(host::LATCH, host::wire[SEGMENTS]);
+  }
+}
+
+void test_dirty_rows_match_baseline()
+{
+  LEDMatrixDriver driver(SEGMENTS, SS_PIN, ORIENTATION);
+  draw(driver);
+  driver.display();
+  host::wire.clear();
+
+  // Every segment of logical rows 1 and 6 changes
+  for (int x = 0; x < 8 * SEGMENTS; x += 8) {
+    driver.setPixel(x, 1, !driver.getPixel(x, 1));
+    driver.setPixel(x + 7, 6, !driver.getPixel(x + 7, 6));
+  }
+  driver.display();
+
+  // INVERT_Y: logical rows 1 and 6 are the registers 7 and 2
+  TEST_ASSERT_TRUE(host::wire == baseline(driver, ORIENTATION, (1 << 1) | (1 << 6)));
+}
+
+// A broadcast goes to all segments once; the same value again is not sent
+void test_broadcast_commands()
+{
+  LEDMatrixDriver driver(SEGMENTS, SS_PIN, ORIENTATION | LEDMatrixDriver::WIRE_ORDER);
+  host::wire.clear();
+
+  driver.setBrightness(7);
+  TEST_ASSERT_EQUAL(SEGMENTS + 1, host::wire.size());
+  for (uint8_t i = 0; i < SEGMENTS; i++) {
+    TEST_ASSERT_EQUAL_HEX16(0x0A07, host::wire[i]);
+  }
+
+  host::wire.clear();
+  driver.setBrightness(7);
+  driver.setEnabled(false);
+  TEST_ASSERT_EQUAL(0, host::wire.size());
+}
+
+// The resync re-sends one register after a frame with data, an idle display sends nothing
+void test_resync_after_sent_frames_only()
+{
+  LEDMatrixDriver driver(SEGMENTS, SS_PIN, ORIENTATION | LEDMatrixDriver::WIRE_ORDER);
+  driver.setRegisterResync(true);
+  draw(driver);
+  driver.display();
+  host::wire.clear();
+
+  for (int i = 0; i < 10; i++) {
+    driver.display();
+  }
+  TEST_ASSERT_EQUAL(0, host::wire.size());
+
+  // A row and a broadcast of a register
+  driver.setPixel(0, 0, !driver.getPixel(0, 0));
+  driver.display();
+  TEST_ASSERT_EQUAL(2 * (SEGMENTS + 1), host::wire.size());
+  uint8_t address = host::wire[SEGMENTS + 1] >> 8;
+  TEST_ASSERT_TRUE(address >= 0x09 && address <= 0x0F);
+
+  // The same from the refresh timer
+  Ticker *ticker = &driver.m_refreshTicker;
+  driver.startRefresh(20);
+  host::wire.clear();
+  ticker->fire();
+  ticker->fire();
+  TEST_ASSERT_EQUAL(0, host::wire.size());
+
+  driver.setPixel(1, 1, !driver.getPixel(1, 1));
+  driver.display();
+  TEST_ASSERT_EQUAL(0, host::wire.size());
+  ticker->fire();
+  TEST_ASSERT_EQUAL(2 * (SEGMENTS + 1), host::wire.size());
+  host::wire.clear();
+  ticker->fire();
+  TEST_ASSERT_EQUAL(0, host::wire.size());
+  driver.stopRefresh();
+}
+
+// Words, transactions and the time on the bus at 10 MHz of a full frame and of a changed pixel
+void test_report_wire_cost()
+{
+  LEDMatrixDriver driver(SEGMENTS, SS_PIN, ORIENTATION | LEDMatrixDriver::WIRE_ORDER);
+  draw(driver);
+  driver.display();
+
+  const char *cases[] = { "full frame", "one pixel" };
+  for (int c = 0; c < 2; c++) {
+    host::wire.clear();
+    unsigned transactions = SPI.transactions;
+    if (c == 0) {
+      driver.invalidate();
+    } else {
+      driver.setPixel(40, 2, !driver.getPixel(40, 2));
+    }
+    driver.display();
+
+    size_t latches = std::count(host::wire.begin(), host::wire.end(), host::LATCH);
+    size_t words = host::wire.size() - latches;
+    char message[128];
+    snprintf(message, sizeof(message), "%s: %u words, %u latches, %u transaction(s), %.1f us on the bus",
+             cases[c], (unsigned)words, (unsigned)latches, SPI.transactions - transactions, words * 16 / 10.0);
+    TEST_MESSAGE(message);
+  }
+}
+
+// Words and the time on the bus at 10 MHz of a dithering cycle of a greyscale icon with grey pixels in every row
+void test_report_dither_cost()
+{
+  static const uint8_t high[8] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+  static const uint8_t low[8] = { 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F };
+  LEDMatrixDriver driver(SEGMENTS, SS_PIN, ORIENTATION | LEDMatrixDriver::WIRE_ORDER);
+  driver.setGreyscale(0, 1, high, low);
+  driver.display();
+  host::wire.clear();
+
+  // Three sub-frames, the second one sends nothing
+  for (int phase = 0; phase < 3; phase++) {
+    driver.m_ditherTicker.fire();
+  }
+  size_t latches = std::count(host::wire.begin(), host::wire.end(), host::LATCH);
+  size_t words = host::wire.size() - latches;
+  TEST_ASSERT_EQUAL(2 * 8 * SEGMENTS, words);
+
+  double busMicros = words * 16 / 10.0;
+  double cycleMicros = 3 * 1000.0 * driver.m_ditherPeriod;
+  char message[160];
+  snprintf(message, sizeof(message), "dithering of %d segments: %u words, %.1f us on the bus per %.0f ms cycle, %.1f%% SPI duty",
+           SEGMENTS, (unsigned)words, busMicros, cycleMicros / 1000, 100 * busMicros / cycleMicros);
+  TEST_MESSAGE(message);
+  driver.clearGreyscale();
+}
+
+int main( int argc, char **argv )
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_full_frame_matches_baseline);
+  RUN_TEST(test_idle_display_sends_nothing);
+  RUN_TEST(test_dirty_row_with_noop_words);
+  RUN_TEST(test_dirty_rows_match_baseline);
+  RUN_TEST(test_broadcast_commands);
+  RUN_TEST(test_resync_after_sent_frames_only);
+  RUN_TEST(test_report_wire_cost);
+  RUN_TEST(test_report_dither_cost);
+  return UNITY_END();
+}
@@ -0,0 +1,252 @@
+/*
+ * The streaming renderer against the framebuffer driver: the same text and icon must put
+ * the same values into the MAX7219 registers, and the control registers are shadowed
+ * and resynced the same way.
+ * FrameStream gets the DDP packets tools/ddp_send.py builds through the UDP stub.
+ */
+
+#include <unity.h>
+#include <MAX7219Chain.h>
+#include <SPI.h>
+#include <Ticker.h>
+#include <WiFiUdp.h>
+#include "LEDMatrixDriver.h"
+#include "LEDMatrixStream.h"
+
+// The test reads the framebuffer of the device
+#define private public
+#include "LEDMatrixDevice.h"
+#undef private
+#include "FrameStream.h"
+
+static const uint8_t SEGMENTS = 8;
+static const uint8_t SS_PIN = 15;
+static const uint8_t ORIENTATION = LEDMatrixDriver::INVERT_DISPLAY_X | LEDMatrixDriver::INVERT_SEGMENT_X | LEDMatrixDriver::INVERT_Y;
+
+static const uint8_t ICON[8] = { 0x3C, 0x42, 0xA5, 0x81, 0xA5, 0x99, 0x42, 0x3C };
+static const char16_t TEXT[] = u"12:34";
+
+void setUp() { host::wire.clear(); host::recording = true; }
+void tearDown() {}
+
+static LEDMatrixStream* createStream()
+{
+  LEDMatrixStream *stream = new LEDMatrixStream(SEGMENTS, SS_PIN, ORIENTATION);
+  stream->addIcon(0, ICON);
+  uint8_t item = stream->addText(8, 8 * SEGMENTS - 8, FontStyle::Fixed);
+  stream->setText(item, TEXT, 5, 0);
+  return stream;
+}
+
+void test_same_registers_as_driver()
+{
+  LEDMatrixDriver driver(SEGMENTS, SS_PIN, ORIENTATION);
+  driver.drawSprite(ICON, 0, 0, 8, 8);
+  Typeface::drawCentered(&driver, FontStyle::Fixed, TEXT, 5, 8, 8 * SEGMENTS - 8);
+  host::wire.clear();
+  driver.display();
+  MAX7219Chain expected(SEGMENTS);
+  expected.apply();
+
+  LEDMatrixStream *stream = createStream();
+  host::wire.clear();
+  stream->display(0);
+  MAX7219Chain chain(SEGMENTS);
+  chain.apply();
+  delete stream;
+
+  TEST_ASSERT_TRUE(expected == chain);
+}
+
+// A register which already has the value is not sent again
+void test_shadowed_registers()
+{
+  LEDMatrixStream stream(SEGMENTS, SS_PIN, ORIENTATION);
+  host::wire.clear();
+
+  stream.setBrightness(7);
+  stream.setEnabled(true);
+  TEST_ASSERT_EQUAL(2 * (SEGMENTS + 1), host::wire.size());
+  TEST_ASSERT_EQUAL_HEX16(0x0A07, host::wire[0]);
+  TEST_ASSERT_EQUAL_HEX16(0x0C01, host::wire[SEGMENTS + 1]);
+
+  host::wire.clear();
+  stream.setBrightness(7);
+  stream.setEnabled(true);
+  stream.setEnabled(true);
+  TEST_ASSERT_EQUAL(0, host::wire.size());
+}
+
+// The resync re-sends one register after a frame with data, an unchanged frame sends nothing
+void test_resync_after_sent_frames_only()
+{
+  LEDMatrixStream *stream = createStream();
+  stream->setRegisterResync(true);
+  host::wire.clear();
+
+  stream->display(0);
+  TEST_ASSERT_EQUAL(8 * (SEGMENTS + 1) + SEGMENTS + 1, host::wire.size());
+  uint8_t address = host::wire[8 * (SEGMENTS + 1)] >> 8;
+  TEST_ASSERT_TRUE(address >= 0x09 && address <= 0x0F);
+
+  host::wire.clear();
+  stream->display(1000);
+  stream->display(2000);
+  TEST_ASSERT_EQUAL(0, host::wire.size());
+  delete stream;
+}
+
+// Rows are compared by checksums, so all of them are sent again after RESEND_FRAMES frames
+void test_periodic_resend()
+{
+  LEDMatrixStream *stream = createStream();
+  host::wire.clear();
+  stream->display(0);
+  MAX7219Chain expected(SEGMENTS);
+  expected.apply();
+
+  host::wire.clear();
+  for (int i = 1; i < LEDMatrixStream::RESEND_FRAMES - 1; i++) {
+    stream->display(i);
+  }
+  TEST_ASSERT_EQUAL(0, host::wire.size());
+
+  stream->display(LEDMatrixStream::RESEND_FRAMES);
+  TEST_ASSERT_EQUAL(8 * (SEGMENTS + 1), host::wire.size());
+  MAX7219Chain chain(SEGMENTS);
+  chain.apply();
+  TEST_ASSERT_TRUE(expected == chain);
+  delete stream;
+}
+
+// packet() of ddp_send.py: flags, sequence, data type, destination, offset, length (big-endian), timecode
+static std::vector<uint8_t> packet( uint8_t seq, const uint8_t *data, uint16_t len, uint32_t offset, bool push )
+{
+  std::vector<uint8_t> p = { (uint8_t)(0x40 | 0x10 | (push ? 0x01 : 0)), seq, 0, 1,
+                             (uint8_t)(offset >> 24), (uint8_t)(offset >> 16), (uint8_t)(offset >> 8), (uint8_t)offset,
+                             (uint8_t)(len >> 8), (uint8_t)len, 0, 0, 0, 0 };
+  p.insert(p.end(), data, data + len);
+  return p;
+}
+
+// frame() of ddp_send.py: a bar at the column n
+static std::vector<uint8_t> frame( uint8_t segments, int n )
+{
+  std::vector<uint8_t> rows(8 * segments, 0);
+  int x = n % (8 * segments);
+  for (int y = 0; y < 8; y++) {
+    rows[y * segments + x / 8] = 0x80 >> (x % 8);
+  }
+  return rows;
+}
+
+// packets() of ddp_send.py: the frame in parts from offset 0, each with the next sequence number
+static std::vector<std::vector<uint8_t>> packets( uint8_t &seq, const std::vector<uint8_t> &data, int parts )
+{
+  std::vector<std::vector<uint8_t>> result;
+  size_t size = (data.size() + parts - 1) / parts;
+  for (size_t offset = 0; offset < data.size(); offset += size) {
+    seq = seq % 15 + 1;
+    size_t len = std::min(size, data.size() - offset);
+    result.push_back(packet(seq, data.data() + offset, len, offset, offset + size >= data.size()));
+  }
+  return result;
+}
+
+static void receive( const std::vector<std::vector<uint8_t>> &datagrams )
+{
+  host::udp.insert(host::udp.end(), datagrams.begin(), datagrams.end());
+}
+
+static bool barAt( LEDMatrixDevice *device, int x )
+{
+  for (int y = 0; y < 8; y++) {
+    for (int i = 0; i < LEDMATRIX_WIDTH; i++) {
+      if (device->m_driver->getPixel(i, y) != (i == x)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Reordered, repeated, wrong-size, incomplete and multi-packet frames through the firmware code
+void test_frame_stream_rules()
+{
+  LEDMatrixDevice *device = new LEDMatrixDevice();
+  FrameStream stream(device);
+  stream.begin(STREAM_UDP_PORT);
+  uint8_t seq = 0;
+
+  receive(packets(seq, frame(LEDMATRIX_SEGMENTS, 5), 1));
+  stream.run();
+  TEST_ASSERT_EQUAL(1, stream.framesShown());
+  TEST_ASSERT_TRUE(stream.active());
+  TEST_ASSERT_TRUE(barAt(device, 5));
+
+  // A frame in three packets is shown when the last one pushes it
+  std::vector<std::vector<uint8_t>> parts = packets(seq, frame(LEDMATRIX_SEGMENTS, 6), 3);
+  TEST_ASSERT_EQUAL(3, parts.size());
+  receive({ parts[0], parts[1] });
+  stream.run();
+  TEST_ASSERT_TRUE(barAt(device, 5));
+  receive({ parts[2] });
+  stream.run();
+  TEST_ASSERT_EQUAL(2, stream.framesShown());
+  TEST_ASSERT_TRUE(barAt(device, 6));
+
+  // Frame 8 arrives before frame 7: 7 is late
+  std::vector<std::vector<uint8_t>> seventh = packets(seq, frame(LEDMATRIX_SEGMENTS, 7), 1);
+  std::vector<std::vector<uint8_t>> eighth = packets(seq, frame(LEDMATRIX_SEGMENTS, 8), 1);
+  receive(eighth);
+  receive(seventh);
+  stream.run();
+  TEST_ASSERT_EQUAL(3, stream.framesShown());
+  TEST_ASSERT_EQUAL(1, stream.framesDropped());
+  TEST_ASSERT_TRUE(barAt(device, 8));
+
+  // Repeated
+  receive(eighth);
+  stream.run();
+  TEST_ASSERT_EQUAL(2, stream.framesDropped());
+
+  // A sender set up for half the segments
+  receive(packets(seq, frame(LEDMATRIX_SEGMENTS / 2, 9), 1));
+  stream.run();
+  TEST_ASSERT_EQUAL(3, stream.framesDropped());
+  TEST_ASSERT_TRUE(barAt(device, 8));
+
+  // The middle part is lost
+  parts = packets(seq, frame(LEDMATRIX_SEGMENTS, 10), 3);
+  receive({ parts[0], parts[2] });
+  stream.run();
+  TEST_ASSERT_EQUAL(3, stream.framesShown());
+  TEST_ASSERT_EQUAL(4, stream.framesDropped());
+  TEST_ASSERT_TRUE(barAt(device, 8));
+
+  // Three frames have waited in the socket, only the newest one is shown
+  for (int n = 11; n <= 13; n++) {
+    receive(packets(seq, frame(LEDMATRIX_SEGMENTS, n), 2));
+  }
+  stream.run();
+  TEST_ASSERT_EQUAL(4, stream.framesShown());
+  TEST_ASSERT_EQUAL(6, stream.framesDropped());
+  TEST_ASSERT_TRUE(barAt(device, 13));
+
+  // The sender has stopped
+  delay(STREAM_TIMEOUT + 1);
+  stream.run();
+  TEST_ASSERT_FALSE(stream.active());
+  delete device;
+}
+
+int main( int argc, char **argv )
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_same_registers_as_driver);
+  RUN_TEST(test_shadowed_registers);
+  RUN_TEST(test_resync_after_sent_frames_only);
+  RUN_TEST(test_periodic_resend);
+  RUN_TEST(test_frame_stream_rules);
+  return UNITY_END();
+}
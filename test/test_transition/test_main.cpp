@@ -0,0 +1,89 @@
+/*
+ * The fade goes dark at its low point and restores the display at the end,
+ * and the progress stays right for long durations.
+ */
+
+#include <unity.h>
+#include <SPI.h>
+#include <Ticker.h>
+#include <MAX7219Chain.h>
+#include "LEDMatrixDriver.h"
+
+// The tests read the progress of the transition
+#define private public
+#include "Transition.h"
+#undef private
+
+static const uint8_t SEGMENTS = 8;
+static const uint8_t SS_PIN = 15;
+static const uint8_t BRIGHTNESS = 5;
+
+static const uint8_t REG_INTENSITY = 0x0A;
+static const uint8_t REG_SHUTDOWN = 0x0C;
+
+void setUp() { host::wire.clear(); host::recording = true; }
+void tearDown() {}
+
+void test_fade_is_dark_at_the_low_point()
+{
+  LEDMatrixDriver driver(SEGMENTS, SS_PIN);
+  driver.setEnabled(true);
+  driver.setBrightness(BRIGHTNESS);
+  MAX7219Chain chain(SEGMENTS);
+  chain.apply();
+
+  Transition transition(SEGMENTS);
+  transition.setEffect(Transition::Effect::Fade);
+  transition.setEasing(Transition::Easing::Linear);
+  transition.setDuration(400);
+  transition.captureOutgoing(&driver);
+  transition.start(&driver, 0);
+
+  TEST_ASSERT_TRUE(transition.step(&driver, 0, BRIGHTNESS));
+  chain.apply();
+  TEST_ASSERT_EQUAL(1, chain.reg(0, REG_SHUTDOWN));
+  TEST_ASSERT_EQUAL(BRIGHTNESS, chain.reg(0, REG_INTENSITY));
+
+  // Intensity 0 is still lit, the low point is shut down
+  TEST_ASSERT_TRUE(transition.step(&driver, 200, BRIGHTNESS));
+  chain.apply();
+  TEST_ASSERT_EQUAL(0, chain.reg(0, REG_SHUTDOWN));
+
+  TEST_ASSERT_TRUE(transition.step(&driver, 300, BRIGHTNESS));
+  chain.apply();
+  TEST_ASSERT_EQUAL(1, chain.reg(0, REG_SHUTDOWN));
+
+  TEST_ASSERT_FALSE(transition.step(&driver, 400, BRIGHTNESS));
+  chain.apply();
+  TEST_ASSERT_EQUAL(1, chain.reg(0, REG_SHUTDOWN));
+  TEST_ASSERT_EQUAL(BRIGHTNESS, chain.reg(0, REG_INTENSITY));
+
+  // A fade which is cancelled at the low point lights the display again
+  transition.start(&driver, 1000);
+  transition.step(&driver, 1200, BRIGHTNESS);
+  transition.cancel(&driver, BRIGHTNESS);
+  chain.apply();
+  TEST_ASSERT_EQUAL(1, chain.reg(0, REG_SHUTDOWN));
+}
+
+// elapsed << 8 does not fit 32 bits after 2^24 ms
+void test_progress_of_long_durations()
+{
+  Transition transition(SEGMENTS);
+  transition.setEasing(Transition::Easing::Linear);
+  transition.setDuration(40000000UL);
+  transition.m_start = 0;
+
+  TEST_ASSERT_EQUAL(64, transition.progress(10000000UL));
+  TEST_ASSERT_EQUAL(128, transition.progress(20000000UL));
+  TEST_ASSERT_EQUAL(192, transition.progress(30000000UL));
+  TEST_ASSERT_EQUAL(256, transition.progress(40000000UL));
+}
+
+int main( int argc, char **argv )
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_fade_is_dark_at_the_low_point);
+  RUN_TEST(test_progress_of_long_durations);
+  return UNITY_END();
+}
@@ -0,0 +1,73 @@
+/*
+ * Decoding of UTF-8 text from MQTT: valid sequences of every length, and the invalid ones
+ * which must become '?' instead of a code point truncated into char16_t.
+ */
+
+#include <unity.h>
+#include <string>
+#include "Utf8.h"
+
+void setUp() {}
+void tearDown() {}
+
+static std::u16string decode( const char *text, size_t capacity = 64 )
+{
+  char16_t buffer[64];
+  size_t len = decodeUtf8(text, buffer, capacity);
+  return std::u16string(buffer, len);
+}
+
+void test_valid_sequences()
+{
+  TEST_ASSERT_TRUE(decode("Abc") == u"Abc");
+  TEST_ASSERT_TRUE(decode("\xC2\x80\xD0\x96") == u"\u0080\u0416");
+  TEST_ASSERT_TRUE(decode("\xE0\xA0\x80\xE2\x82\xAC\xEF\xBF\xBD") == u"\u0800\u20AC\uFFFD");
+  TEST_ASSERT_TRUE(decode("\xED\x9F\xBF\xEE\x80\x80") == u"\uD7FF\uE000");
+
+  // Outside the Basic Multilingual Plane there are no glyphs
+  TEST_ASSERT_TRUE(decode("\xF0\x9F\x98\x80!") == u"?!");
+}
+
+void test_overlong_forms()
+{
+  TEST_ASSERT_TRUE(decode("\xC0\x80x") == u"?x");
+  TEST_ASSERT_TRUE(decode("\xC1\xBFx") == u"?x");
+  TEST_ASSERT_TRUE(decode("\xE0\x80\x80x") == u"?x");
+  TEST_ASSERT_TRUE(decode("\xE0\x9F\xBFx") == u"?x");
+  TEST_ASSERT_TRUE(decode("\xF0\x80\x80\x80x") == u"?x");
+  TEST_ASSERT_TRUE(decode("\xF0\x8F\xBF\xBFx") == u"?x");
+}
+
+void test_surrogates()
+{
+  TEST_ASSERT_TRUE(decode("\xED\xA0\x80x") == u"?x");
+  TEST_ASSERT_TRUE(decode("\xED\xAF\xBF\xED\xB0\x80x") == u"??x");
+  TEST_ASSERT_TRUE(decode("\xED\xBF\xBFx") == u"?x");
+}
+
+void test_out_of_range()
+{
+  TEST_ASSERT_TRUE(decode("\xF4\x90\x80\x80x") == u"?x");
+  TEST_ASSERT_TRUE(decode("\xF7\xBF\xBF\xBFx") == u"?x");
+  TEST_ASSERT_TRUE(decode("\xF8\x88\x80\x80\x80x") == u"?????x");
+  TEST_ASSERT_TRUE(decode("\xFFx") == u"?x");
+}
+
+void test_truncated_and_capacity()
+{
+  TEST_ASSERT_TRUE(decode("\xE2\x82x") == u"?x");
+  TEST_ASSERT_TRUE(decode("\x80x") == u"?x");
+  TEST_ASSERT_TRUE(decode("\xD0") == u"?");
+  TEST_ASSERT_TRUE(decode("\xD0\x96\xD0\x96\xD0\x96", 2) == u"\u0416\u0416");
+}
+
+int main( int argc, char **argv )
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_valid_sequences);
+  RUN_TEST(test_overlong_forms);
+  RUN_TEST(test_surrogates);
+  RUN_TEST(test_out_of_range);
+  RUN_TEST(test_truncated_and_capacity);
+  return UNITY_END();
+}
@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+"""
+Sends frames to the informer by UDP in the DDP format and reports latency and fps.
+
+  ddp_send.py 192.168.1.50               animation at 30 fps to the device
+  ddp_send.py --listen                   a stand-in for the device on this host
+  ddp_send.py 127.0.0.1 --reorder 0.1    sends to the stand-in, 10% of frames out of order
+  ddp_send.py 127.0.0.1 --parts 3        every frame in 3 packets, the last one pushes it
+
+A frame is 8 rows of one byte per segment, the MSB is the leftmost pixel.
+Every packet has a timecode (seconds in 16.16 fixed point) with the time it was sent,
+so the stand-in on the same host reports the latency of the frames.
+The stand-in is a copy of the rules of FrameStream for a quick check of a sender; the firmware
+itself is tested with packets of the same layout in test/test_stream.
+"""
+
+import argparse
+import random
+import socket
+import struct
+import time
+
+PORT = 4048
+FLAG_VERSION = 0x40
+FLAG_TIMECODE = 0x10
+FLAG_PUSH = 0x01
+
+
+def timecode():
+    return int(time.time() * 65536) & 0xFFFFFFFF
+
+
+def packet(seq, data, offset=0, push=True):
+    # flags, sequence, data type, destination, offset, length, timecode
+    flags = FLAG_VERSION | FLAG_TIMECODE | (FLAG_PUSH if push else 0)
+    header = struct.pack(">BBBBIHI", flags, seq, 0, 1, offset, len(data), timecode())
+    return header + data
+
+
+def packets(seq, data, parts):
+    # The parts follow each other from offset 0, every packet has the next sequence number
+    size = -(-len(data) // parts)
+    result = []
+    for offset in range(0, len(data), size):
+        seq = seq % 15 + 1
+        result.append(packet(seq, data[offset:offset + size], offset, offset + size >= len(data)))
+    return seq, result
+
+
+def frame(segments, n):
+    # A bar moving over the display
+    x = n % (8 * segments)
+    rows = bytearray(8 * segments)
+    for y in range(8):
+        rows[y * segments + x // 8] = 0x80 >> (x % 8)
+    return bytes(rows)
+
+
+def send(args):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    period = 1.0 / args.fps
+    delayed = None
+    seq = 0
+    n = 0
+    start = time.monotonic()
+    while args.frames == 0 or n < args.frames:
+        seq, data = packets(seq, frame(args.segments, n), args.parts)
+        if delayed is None and random.random() < args.reorder:
+            delayed = data  # goes after the next frame, the receiver must drop it
+        else:
+            for p in data + (delayed or []):
+                sock.sendto(p, (args.host, args.port))
+            delayed = None
+        n += 1
+        time.sleep(max(0.0, start + n * period - time.monotonic()))
+    print("sent %d frames in %.1f s" % (n, time.monotonic() - start))
+
+
+def listen(args):
+    # The same rules as FrameStream on the device
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(("", args.port))
+    sock.settimeout(1.0)
+    last_seq = 0
+    last_packet = 0.0
+    frame_size = 8 * args.segments
+    frame_bytes = 0
+    shown = dropped = 0
+    latencies = []
+    report = time.monotonic()
+    frames_in_second = 0
+    print("listening on UDP port %d" % args.port)
+    while True:
+        try:
+            data = sock.recv(2048)
+        except socket.timeout:
+            data = None
+        now = time.monotonic()
+
+        if data and len(data) >= 10 and (data[0] & 0xC0) == FLAG_VERSION:
+            header = 14 if data[0] & FLAG_TIMECODE else 10
+            offset, length = struct.unpack(">IH", data[4:10])
+            if now - last_packet > args.timeout:
+                last_seq = 0
+            seq = data[1] & 0x0F
+            ahead = (seq - last_seq + 15) % 15
+            if len(data) < header + length or offset + length > frame_size:
+                dropped += 1
+            elif seq != 0 and last_seq != 0 and (ahead == 0 or ahead > 7):
+                dropped += 1
+            else:
+                if seq != 0:
+                    last_seq = seq
+                last_packet = now
+                # The parts of a frame follow each other from offset 0, a pushed frame must be complete
+                if offset == 0:
+                    frame_bytes = 0
+                frame_bytes = frame_bytes + length if offset == frame_bytes else -1
+                if data[0] & FLAG_PUSH:
+                    if frame_bytes == frame_size:
+                        shown += 1
+                        frames_in_second += 1
+                    else:
+                        dropped += 1
+                    frame_bytes = 0
+                if header == 14:
+                    sent = struct.unpack(">I", data[10:14])[0]
+                    latencies.append(((timecode() - sent) & 0xFFFFFFFF) / 65.536)
+
+        if now - report >= 1.0:
+            if latencies:
+                latencies.sort()
+                print("fps %3d  shown %6d  dropped %4d  latency ms: median %.2f  max %.2f" % (
+                    frames_in_second, shown, dropped, latencies[len(latencies) // 2], latencies[-1]))
+            elif shown and now - last_packet > args.timeout:
+                print("stream stopped, back to the content")
+                shown = dropped = 0
+            latencies = []
+            frames_in_second = 0
+            report = now
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("host", nargs="?", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=PORT)
+    parser.add_argument("--listen", action="store_true", help="receive and report instead of sending")
+    parser.add_argument("--fps", type=float, default=30)
+    parser.add_argument("--frames", type=int, default=0, help="0 - until interrupted")
+    parser.add_argument("--segments", type=int, default=8, help="LEDMATRIX_SEGMENTS of the device")
+    parser.add_argument("--reorder", type=float, default=0.0, help="share of frames sent out of order")
+    parser.add_argument("--parts", type=int, default=1, help="packets per frame")
+    parser.add_argument("--timeout", type=float, default=1.0, help="seconds without frames until the stream stops")
+    args = parser.parse_args()
+    try:
+        listen(args) if args.listen else send(args)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()